@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PENUM_BINARYIO_H_
+#define PENUM_BINARYIO_H_
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <pokerstove/peval/PokerHandEvaluator.h>
+
+namespace pokerstove
+{
+/**
+ * Raw reads and writes for the checkpoint and partial result files.
+ * Values are written in the byte order of the machine, the files are
+ * not meant to move between architectures.
+ */
+namespace binaryio
+{
+template <typename T>
+inline void put (std::ostream& out, const T& value)
+{
+    out.write (reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+inline void get (std::istream& in, T& value)
+{
+    in.read (reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+// exact shares are always stored as 128 bits, low word first.  The
+// shifts are split so they are defined for a 64 bit ExactShares too.
+inline void putUnits (std::ostream& out, ExactShares units)
+{
+    put (out, static_cast<uint64_t>(units));
+    put (out, static_cast<uint64_t>(units >> 32 >> 32));
+}
+
+inline void getUnits (std::istream& in, ExactShares& units)
+{
+    uint64_t low = 0;
+    uint64_t high = 0;
+    get (in, low);
+    get (in, high);
+    units = (static_cast<ExactShares>(high) << 32 << 32) | low;
+}
+
+// strings are a 64 bit length and the bytes
+inline void putString (std::ostream& out, const std::string& s)
+{
+    put (out, static_cast<uint64_t>(s.size()));
+    out.write (s.data(), s.size());
+}
+
+inline bool getString (std::istream& in, std::string& s)
+{
+    uint64_t n = 0;
+    get (in, n);
+    if (!in || n > (1 << 24))
+        return false;
+    s.resize (n);
+    in.read (&s[0], n);
+    return static_cast<bool>(in);
+}
+}
+}
+
+#endif  // PENUM_BINARYIO_H_
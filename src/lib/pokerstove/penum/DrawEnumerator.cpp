@@ -0,0 +1,410 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#include "DrawEnumerator.h"
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <pokerstove/peval/Card.h>
+#include <pokerstove/util/combinations.h>
+#include <pokerstove/util/lastbit.h>
+
+using std::vector;
+
+namespace pokerstove {
+
+namespace {
+
+/**
+ * The live deck, with the position of each of its cards.  A replacement
+ * set is ranked among the sets of its size by the sum of
+ * choose(position, i+1) over its positions in increasing order.
+ */
+class LiveDeck
+{
+public:
+    LiveDeck (const CardSet& out, size_t maxDraw)
+        : _cards ()
+        , _ranks (maxDraw, vector<uint64_t> (STANDARD_DECK_SIZE, 0))
+    {
+        for (size_t c=0; c<STANDARD_DECK_SIZE; c++)
+        {
+            if (out.contains (Card (c)))
+                continue;
+            for (size_t i=0; i<maxDraw; i++)
+                _ranks[i][c] = choose (_cards.size(), i+1);
+            _cards.push_back (1ULL << c);
+        }
+    }
+
+    size_t size () const                        { return _cards.size(); }
+    const vector<uint64_t>& cards () const      { return _cards; }
+
+    uint64_t rank (uint64_t mask) const
+    {
+        uint64_t ret = 0;
+        for (size_t i=0; mask; mask &= mask-1, i++)
+            ret += _ranks[i][lastbit (mask)];
+        return ret;
+    }
+
+private:
+    vector<uint64_t> _cards;
+    vector<vector<uint64_t> > _ranks;
+};
+
+/**
+ * The evaluations of a player's kept cards with every replacement set
+ * from the live deck, each made the first time it is needed.  Once
+ * filled, a table may be read from several threads.
+ */
+class Replacements
+{
+public:
+    Replacements (const CardSet& kept, size_t draw, const LiveDeck& deck,
+                  const PokerHandEvaluator& peval)
+        : _kept (kept)
+        , _draw (draw)
+        , _deck (deck)
+        , _peval (peval)
+        , _evals (choose (deck.size(), draw))
+        , _known (_evals.size(), 0)
+    {}
+
+    size_t draw () const    { return _draw; }
+
+    const PokerHandEvaluation& operator() (uint64_t replacement)
+    {
+        const uint64_t index = _deck.rank (replacement);
+        if (!_known[index])
+        {
+            _evals[index] = _peval.evaluateHand (_kept | CardSet (replacement), CardSet());
+            _known[index] = 1;
+        }
+        return _evals[index];
+    }
+
+    void fill ()
+    {
+        const vector<uint64_t>& cards = _deck.cards();
+        combinations cc (cards.size(), _draw);
+        do
+        {
+            uint64_t mask = 0;
+            for (size_t i=0; i<_draw; i++)
+                mask |= cards[cc[i]];
+            (*this) (mask);
+        }
+        while (cc.next ());
+    }
+
+private:
+    CardSet _kept;
+    size_t _draw;
+    const LiveDeck& _deck;
+    const PokerHandEvaluator& _peval;
+    vector<PokerHandEvaluation> _evals;
+    vector<char> _known;
+};
+
+/**
+ * The better of two hands, by the high and then the low.
+ */
+inline const PokerHandEvaluation& better (const PokerHandEvaluation& a,
+                                          const PokerHandEvaluation& b)
+{
+    if (b.high() > a.high() || (b.high() == a.high() && b.low() > a.low()))
+        return b;
+    return a;
+}
+
+/**
+ * Deals the draws of every player, one slot per player and draw, and
+ * awards the best hand each made.
+ */
+class DrawDealer
+{
+public:
+    DrawDealer (const vector<Replacements*>& players, const LiveDeck& deck,
+                size_t ndraws, const PokerHandEvaluator& peval)
+        : _players (players)
+        , _deck (deck)
+        , _ndraws (ndraws)
+        , _peval (peval)
+        , _best (players.size())
+        , _remaining ()
+        , _subsets ()
+    {
+        _remaining.reserve (ndraws*players.size());
+        _subsets.reserve (ndraws*players.size());
+        for (size_t s=0; s<ndraws*players.size(); s++)
+        {
+            _remaining.push_back (vector<uint64_t> ());
+            _subsets.push_back (combinations (deck.size(), players[s % players.size()]->draw()));
+        }
+    }
+
+    void enumerate (vector<EquityResult>& results)
+    {
+        start ();
+        deal (0, 0, results);
+    }
+
+    void sample (size_t samples, uint64_t seed, vector<EquityResult>& results)
+    {
+        std::mt19937_64 rng (seed);
+        vector<uint64_t> cards = _deck.cards();
+        const size_t nplayers = _players.size();
+        for (size_t t=0; t<samples; t++)
+        {
+            start ();
+            size_t next = 0;
+            for (size_t s=0; s<_ndraws*nplayers; s++)
+            {
+                const size_t p = s % nplayers;
+                const size_t draw = _players[p]->draw();
+                if (draw == 0)
+                    continue;
+                uint64_t mask = 0;
+                for (size_t i=0; i<draw; i++, next++)
+                {
+                    std::uniform_int_distribution<size_t> pick (next, cards.size()-1);
+                    std::swap (cards[next], cards[pick (rng)]);
+                    mask |= cards[next];
+                }
+                const PokerHandEvaluation& made = (*_players[p]) (mask);
+                _best[p] = (s < nplayers) ? made : better (_best[p], made);
+            }
+            _peval.awardShowdown (_best, results);
+        }
+    }
+
+private:
+    // the pat hands, the others are made by their first draw
+    void start ()
+    {
+        for (size_t p=0; p<_players.size(); p++)
+            if (_players[p]->draw() == 0)
+                _best[p] = (*_players[p]) (0);
+    }
+
+    void deal (size_t slot, uint64_t used, vector<EquityResult>& results)
+    {
+        const size_t nplayers = _players.size();
+        while (slot < _ndraws*nplayers && _players[slot % nplayers]->draw() == 0)
+            slot++;
+        if (slot == _ndraws*nplayers)
+        {
+            _peval.awardShowdown (_best, results);
+            return;
+        }
+
+        const size_t p = slot % nplayers;
+        const size_t draw = _players[p]->draw();
+        vector<uint64_t>& remaining = _remaining[slot];
+        remaining.clear ();
+        for (size_t i=0; i<_deck.size(); i++)
+            if ((_deck.cards()[i] & used) == 0)
+                remaining.push_back (_deck.cards()[i]);
+
+        // the first draw replaces the hand as dealt, later ones keep the best
+        const PokerHandEvaluation saved = _best[p];
+        combinations& cc = _subsets[slot];
+        cc.reset (remaining.size(), draw);
+        do
+        {
+            uint64_t mask = 0;
+            for (size_t i=0; i<draw; i++)
+                mask |= remaining[cc[i]];
+            const PokerHandEvaluation& made = (*_players[p]) (mask);
+            _best[p] = (slot < nplayers) ? made : better (saved, made);
+            deal (slot+1, used | mask, results);
+        }
+        while (cc.next ());
+        _best[p] = saved;
+    }
+
+    const vector<Replacements*>& _players;
+    const LiveDeck& _deck;
+    size_t _ndraws;
+    const PokerHandEvaluator& _peval;
+    vector<PokerHandEvaluation> _best;
+    vector<vector<uint64_t> > _remaining;
+    vector<combinations> _subsets;
+};
+
+/**
+ * The cards out of the live deck, after checking the hands and discards.
+ */
+CardSet checkDraws (const vector<CardSet>& hands,
+                    const vector<CardSet>& discards,
+                    const CardSet& dead,
+                    const PokerHandEvaluator& peval,
+                    size_t ndraws)
+{
+    if (hands.size() < 2)
+        throw std::runtime_error ("DrawEnumerator, at least two players are required");
+    if (discards.size() != hands.size())
+        throw std::runtime_error ("DrawEnumerator, one set of discards is required per player");
+
+    CardSet out = dead;
+    size_t drawn = 0;
+    for (size_t i=0; i<hands.size(); i++)
+    {
+        if (hands[i].size() != peval.handSize())
+            throw std::runtime_error ("DrawEnumerator, incomplete hand: " + hands[i].str());
+        if (out.intersects (hands[i]))
+            throw std::runtime_error ("DrawEnumerator, card dealt twice: " + hands[i].str());
+        if (!hands[i].contains (discards[i]))
+            throw std::runtime_error ("DrawEnumerator, discards not in hand: " + discards[i].str());
+        out |= hands[i];
+        drawn += discards[i].size();
+    }
+    if (drawn*ndraws > STANDARD_DECK_SIZE - out.size())
+        throw std::runtime_error ("DrawEnumerator, too few live cards for the draws");
+    return out;
+}
+
+size_t numberOfDraws (const PokerHandEvaluator& peval)
+{
+    return std::max<size_t> (peval.numDraws(), 1);
+}
+
+CardSet keptCards (const CardSet& hand, const CardSet& discard)
+{
+    return CardSet (hand.mask() & ~discard.mask());
+}
+
+}
+
+DrawEnumerator::DrawEnumerator ()
+    : _samples (0)
+    , _seed (0)
+{
+}
+
+void DrawEnumerator::setSamples (size_t samples, uint64_t seed)
+{
+    _samples = samples;
+    _seed = seed;
+}
+
+vector<EquityResult> DrawEnumerator::calculateEquity (const vector<CardSet>& hands,
+                                                      const vector<CardSet>& discards,
+                                                      const CardSet& dead,
+                                                      boost::shared_ptr<PokerHandEvaluator> peval) const
+{
+    const size_t ndraws = numberOfDraws (*peval);
+    const LiveDeck deck (checkDraws (hands, discards, dead, *peval, ndraws), peval->handSize());
+
+    vector<Replacements> tables;
+    for (size_t i=0; i<hands.size(); i++)
+        tables.push_back (Replacements (keptCards (hands[i], discards[i]), discards[i].size(),
+                                        deck, *peval));
+    vector<Replacements*> players;
+    for (size_t i=0; i<tables.size(); i++)
+        players.push_back (&tables[i]);
+
+    vector<EquityResult> results (hands.size(), EquityResult());
+    DrawDealer dealer (players, deck, ndraws, *peval);
+    if (_samples == 0)
+        dealer.enumerate (results);
+    else
+        dealer.sample (_samples, _seed, results);
+    return results;
+}
+
+DrawChoice DrawEnumerator::bestDraw (const vector<CardSet>& hands,
+                                     const vector<CardSet>& discards,
+                                     size_t player,
+                                     const CardSet& dead,
+                                     boost::shared_ptr<PokerHandEvaluator> peval,
+                                     size_t threads) const
+{
+    if (player >= hands.size())
+        throw std::runtime_error ("DrawEnumerator, no such player");
+
+    // the player's discards do not change the live deck
+    vector<CardSet> choices;
+    const CardSet hand = hands[player];
+    for (size_t size=0; size<=hand.size(); size++)
+    {
+        combinations cc (hand.size(), size);
+        vector<uint64_t> cards;
+        for (uint64_t mask=hand.mask(); mask; mask &= mask-1)
+            cards.push_back (mask & ~(mask-1));
+        do
+        {
+            uint64_t discard = 0;
+            for (size_t i=0; i<size; i++)
+                discard |= cards[cc[i]];
+            choices.push_back (CardSet (discard));
+        }
+        while (cc.next ());
+    }
+
+    // check against the largest discard, which needs the most live cards
+    vector<CardSet> draws = discards;
+    if (player < draws.size())
+        draws[player] = hand;
+    const size_t ndraws = numberOfDraws (*peval);
+    const LiveDeck deck (checkDraws (hands, draws, dead, *peval, ndraws), peval->handSize());
+
+    // the other players' evaluations are made up front and shared
+    vector<Replacements> others;
+    for (size_t i=0; i<hands.size(); i++)
+    {
+        others.push_back (Replacements (keptCards (hands[i], draws[i]), draws[i].size(),
+                                        deck, *peval));
+        if (i != player)
+            others.back().fill ();
+    }
+
+    if (threads == 0)
+        threads = std::max<size_t> (std::thread::hardware_concurrency(), 1);
+    threads = std::min (threads, choices.size());
+
+    vector<DrawChoice> tried (choices.size());
+    auto search = [&] (size_t first)
+    {
+        for (size_t c=first; c<choices.size(); c+=threads)
+        {
+            Replacements mine (keptCards (hand, choices[c]), choices[c].size(), deck, *peval);
+            vector<Replacements*> players;
+            for (size_t i=0; i<others.size(); i++)
+                players.push_back (i == player ? &mine : &others[i]);
+
+            DrawChoice& choice = tried[c];
+            choice.discard = choices[c];
+            choice.results.assign (hands.size(), EquityResult());
+            DrawDealer dealer (players, deck, ndraws, *peval);
+            if (_samples == 0)
+                dealer.enumerate (choice.results);
+            else
+                dealer.sample (_samples, _seed, choice.results);
+
+            double total = 0.0;
+            for (size_t i=0; i<choice.results.size(); i++)
+                total += choice.results[i].winShares + choice.results[i].tieShares;
+            const EquityResult& mineResult = choice.results[player];
+            choice.equity = (mineResult.winShares + mineResult.tieShares) / total;
+        }
+    };
+
+    vector<std::thread> workers;
+    for (size_t t=1; t<threads; t++)
+        workers.push_back (std::thread (search, t));
+    search (0);
+    for (size_t t=0; t<workers.size(); t++)
+        workers[t].join ();
+
+    size_t best = 0;
+    for (size_t c=1; c<tried.size(); c++)
+        if (tried[c].equity > tried[best].equity)
+            best = c;
+    return tried[best];
+}
+
+}
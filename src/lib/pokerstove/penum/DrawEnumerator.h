@@ -0,0 +1,91 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PENUM_DRAWENUMERATOR_H_
+#define PENUM_DRAWENUMERATOR_H_
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <pokerstove/peval/PokerHandEvaluator.h>
+
+namespace pokerstove
+{
+/**
+ * A discard and the equity it earns, see DrawEnumerator::bestDraw.
+ */
+struct DrawChoice
+{
+    CardSet discard;
+    double equity;
+    std::vector<EquityResult> results;
+
+    DrawChoice ()
+        : discard ()
+        , equity (0.0)
+        , results ()
+    {}
+};
+
+/**
+ * Equity in the draw games, such as triple draw ('t') and badugi ('b').
+ * Each player holds a complete hand and throws away a set of discards,
+ * and in every draw the discards are replaced from the live deck, the
+ * cards no player holds or has thrown away and which are not dead.  The
+ * game's numDraws is the number of draws, at least one.  After the first
+ * draw a player throws away the cards just drawn and draws to the same
+ * kept cards again, and shows down the best of the hands made, so a
+ * player who makes a hand stands on it.  A player with no discards is
+ * pat.
+ *
+ * The evaluation of a player's kept cards with each replacement set is
+ * made once and reused for every other draw, opponent's replacements and
+ * sample which meet it.
+ */
+class DrawEnumerator
+{
+public:
+    DrawEnumerator ();
+
+    /**
+     * With no samples, the default, every way of dealing the draws is
+     * enumerated, which is practical for a single draw of a few cards.
+     * Otherwise the results are from this many deals sampled from the
+     * live deck, starting from the seed.
+     */
+    void setSamples (size_t samples, uint64_t seed=0);
+    size_t samples () const              { return _samples; }
+
+    /**
+     * The share counts of each player, summed over the deals, for the
+     * discards given.  Throws std::runtime_error for fewer than two
+     * players, a hand which is not complete, hands which share a card,
+     * discards which are not in the hand, or a live deck too small for
+     * the draws.
+     */
+    std::vector<EquityResult> calculateEquity (const std::vector<CardSet>& hands,
+                                               const std::vector<CardSet>& discards,
+                                               const CardSet& dead,
+                                               boost::shared_ptr<PokerHandEvaluator> peval) const;
+
+    /**
+     * The discard of player which earns the most equity against the other
+     * players' discards, found by trying all of the subsets of the hand.
+     * The discards of the player are ignored.  The subsets are split
+     * between threads threads, by default one for each core, and the
+     * evaluations of the other players are shared between them.  Ties go
+     * to the smaller discard.  Throws as calculateEquity does.
+     */
+    DrawChoice bestDraw (const std::vector<CardSet>& hands,
+                         const std::vector<CardSet>& discards,
+                         size_t player,
+                         const CardSet& dead,
+                         boost::shared_ptr<PokerHandEvaluator> peval,
+                         size_t threads=0) const;
+
+private:
+    size_t _samples;
+    uint64_t _seed;
+};
+}
+
+#endif  // PENUM_DRAWENUMERATOR_H_
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <pokerstove/peval/Card.h>
+#include "DrawEnumerator.h"
+
+using namespace pokerstove;
+using namespace std;
+
+namespace {
+
+vector<CardSet> makeHands(const vector<string>& hands)
+{
+    vector<CardSet> ret;
+    for (size_t i=0; i<hands.size(); i++)
+        ret.push_back(CardSet(hands[i]));
+    return ret;
+}
+
+boost::shared_ptr<PokerHandEvaluator> drawGame(const string& game, size_t draws)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc(game);
+    peval->setNumDraws(draws);
+    return peval;
+}
+
+void expectSharesNear(const vector<EquityResult>& expected,
+                      const vector<EquityResult>& actual,
+                      double tolerance)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i=0; i<expected.size(); i++)
+    {
+        EXPECT_NEAR(expected[i].winShares, actual[i].winShares, tolerance) << "player " << i;
+        EXPECT_NEAR(expected[i].tieShares, actual[i].tieShares, tolerance) << "player " << i;
+    }
+}
+
+double equityOf(const vector<EquityResult>& results, size_t player)
+{
+    double total = 0.0;
+    for (size_t i=0; i<results.size(); i++)
+        total += results[i].winShares + results[i].tieShares;
+    return (results[player].winShares + results[player].tieShares) / total;
+}
+
+/**
+ * Draw one card to the first hand, by looping over the live cards, and
+ * one to the second unless it is pat.  With two draws the first hand
+ * draws twice and keeps the better, against a pat second hand.
+ */
+vector<EquityResult> bruteForce(const PokerHandEvaluator& peval,
+                                const vector<CardSet>& hands,
+                                const vector<CardSet>& discards,
+                                size_t draws)
+{
+    CardSet out = hands[0] | hands[1];
+    CardSet kept0(hands[0].mask() & ~discards[0].mask());
+    CardSet kept1(hands[1].mask() & ~discards[1].mask());
+    vector<CardSet> live;
+    for (size_t c=0; c<STANDARD_DECK_SIZE; c++)
+        if (!out.contains(Card(c)))
+            live.push_back(CardSet(Card(c)));
+
+    vector<EquityResult> results(2, EquityResult());
+    vector<PokerHandEvaluation> evals(2);
+    for (size_t x=0; x<live.size(); x++)
+    {
+        evals[0] = peval.evaluateHand(kept0 | live[x], CardSet());
+        if (draws == 1 && discards[1].size() == 0)
+        {
+            evals[1] = peval.evaluateHand(hands[1], CardSet());
+            peval.awardShowdown(evals, results);
+            continue;
+        }
+        for (size_t y=0; y<live.size(); y++)
+        {
+            if (x == y)
+                continue;
+            if (draws == 1)
+            {
+                evals[1] = peval.evaluateHand(kept1 | live[y], CardSet());
+            }
+            else
+            {
+                PokerHandEvaluation first = peval.evaluateHand(kept0 | live[x], CardSet());
+                PokerHandEvaluation second = peval.evaluateHand(kept0 | live[y], CardSet());
+                evals[0] = second.high() > first.high() ? second : first;
+                evals[1] = peval.evaluateHand(hands[1], CardSet());
+            }
+            peval.awardShowdown(evals, results);
+        }
+    }
+    return results;
+}
+
+}
+
+TEST(DrawEnumerator, OneCardAgainstPat)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = drawGame("t", 1);
+    vector<CardSet> hands = makeHands({"2c3d4h5sKc", "2h3h4d6c8s"});
+    vector<CardSet> discards = makeHands({"Kc", ""});
+
+    DrawEnumerator draw;
+    vector<EquityResult> results = draw.calculateEquity(hands, discards, CardSet(), peval);
+    expectSharesNear(bruteForce(*peval, hands, discards, 1), results, 1e-9);
+    EXPECT_DOUBLE_EQ(42.0, results[0].winShares + results[0].tieShares +
+                           results[1].winShares + results[1].tieShares);
+}
+
+TEST(DrawEnumerator, BothDrawOne)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = drawGame("t", 1);
+    vector<CardSet> hands = makeHands({"2c3d4h7sKc", "2h3h4d6cQs"});
+    vector<CardSet> discards = makeHands({"Kc", "Qs"});
+
+    DrawEnumerator draw;
+    expectSharesNear(bruteForce(*peval, hands, discards, 1),
+                     draw.calculateEquity(hands, discards, CardSet(), peval), 1e-9);
+}
+
+TEST(DrawEnumerator, KeepsTheBestOfTheDraws)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = drawGame("t", 2);
+    vector<CardSet> hands = makeHands({"2c3d4h7sKc", "2h3h4d6c8s"});
+    vector<CardSet> discards = makeHands({"Kc", ""});
+
+    DrawEnumerator draw;
+    vector<EquityResult> twice = draw.calculateEquity(hands, discards, CardSet(), peval);
+    expectSharesNear(bruteForce(*peval, hands, discards, 2), twice, 1e-9);
+
+    boost::shared_ptr<PokerHandEvaluator> once = drawGame("t", 1);
+    EXPECT_GT(equityOf(twice, 0),
+              equityOf(draw.calculateEquity(hands, discards, CardSet(), once), 0));
+}
+
+TEST(DrawEnumerator, SamplesNearTheEnumeration)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = drawGame("b", 1);
+    vector<CardSet> hands = makeHands({"Ac2d3hKh", "As4c5d7h"});
+    vector<CardSet> discards = makeHands({"Kh", "As"});
+
+    DrawEnumerator draw;
+    double exact = equityOf(draw.calculateEquity(hands, discards, CardSet(), peval), 0);
+    draw.setSamples(20000, 7);
+    EXPECT_NEAR(exact, equityOf(draw.calculateEquity(hands, discards, CardSet(), peval), 0), 0.02);
+}
+
+TEST(DrawEnumerator, DeadCardsAreNotDrawn)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = drawGame("t", 1);
+    vector<CardSet> hands = makeHands({"2c3d4h5sKc", "2h3h4d6c8s"});
+    vector<CardSet> discards = makeHands({"Kc", ""});
+
+    DrawEnumerator draw;
+    vector<EquityResult> results =
+        draw.calculateEquity(hands, discards, CardSet("7c7d7h7s"), peval);
+    EXPECT_DOUBLE_EQ(38.0, results[0].winShares + results[0].tieShares +
+                           results[1].winShares + results[1].tieShares);
+}
+
+TEST(DrawEnumerator, BestDrawTriesEveryDiscard)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = drawGame("t", 1);
+    vector<CardSet> hands = makeHands({"2c3d4h8sKc", "2h3h5d6c9s"});
+    vector<CardSet> discards = makeHands({"", ""});
+
+    DrawEnumerator draw;
+    DrawChoice one = draw.bestDraw(hands, discards, 0, CardSet(), peval, 1);
+    DrawChoice three = draw.bestDraw(hands, discards, 0, CardSet(), peval, 3);
+    EXPECT_EQ(one.discard, three.discard);
+    EXPECT_DOUBLE_EQ(one.equity, three.equity);
+
+    // no single discard does better than the best
+    const char * cards[] = {"", "Kc", "8s", "8sKc", "4h8sKc", "2c3d4h8sKc"};
+    for (size_t i=0; i<sizeof(cards)/sizeof(cards[0]); i++)
+    {
+        discards[0] = CardSet(cards[i]);
+        EXPECT_GE(one.equity + 1e-12,
+                  equityOf(draw.calculateEquity(hands, discards, CardSet(), peval), 0)) << cards[i];
+    }
+    discards[0] = one.discard;
+    EXPECT_DOUBLE_EQ(one.equity, equityOf(draw.calculateEquity(hands, discards, CardSet(), peval), 0));
+    EXPECT_EQ(CardSet("Kc"), one.discard);
+}
+
+TEST(DrawEnumerator, RejectsBadDraws)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = drawGame("t", 1);
+    DrawEnumerator draw;
+    EXPECT_THROW(draw.calculateEquity(makeHands({"2c3d4h5sKc"}), makeHands({""}), CardSet(), peval),
+                 std::runtime_error);
+    EXPECT_THROW(draw.calculateEquity(makeHands({"2c3d4h5s", "2h3h4d6c8s"}), makeHands({"", ""}),
+                                      CardSet(), peval),
+                 std::runtime_error);
+    EXPECT_THROW(draw.calculateEquity(makeHands({"2c3d4h5sKc", "2c3h4d6c8s"}), makeHands({"", ""}),
+                                      CardSet(), peval),
+                 std::runtime_error);
+    EXPECT_THROW(draw.calculateEquity(makeHands({"2c3d4h5sKc", "2h3h4d6c8s"}), makeHands({"Kd", ""}),
+                                      CardSet(), peval),
+                 std::runtime_error);
+}
@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#include "EquityCheckpoint.h"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include "BinaryIO.h"
+
+using std::string;
+using std::runtime_error;
+
+namespace pokerstove {
+
+using namespace binaryio;
+
+namespace {
+
+const uint32_t CHECKPOINT_MAGIC = 0x4b435350;    // "PSCK"
+const uint32_t CHECKPOINT_VERSION = 2;
+
+}
+
+void EquityCheckpoint::write (const string& filename) const
+{
+    string tmpname = filename + ".tmp";
+    {
+        std::ofstream out (tmpname.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw runtime_error ("EquityCheckpoint, can not open " + tmpname);
+
+        put (out, CHECKPOINT_MAGIC);
+        put (out, CHECKPOINT_VERSION);
+        put (out, fingerprint);
+        put (out, outer);
+        put (out, inner);
+        put (out, live);
+        put (out, static_cast<uint64_t>(deck.size()));
+        out.write (reinterpret_cast<const char*>(&deck[0]), deck.size());
+        put (out, static_cast<uint64_t>(results.size()));
+        for (size_t i=0; i<results.size(); i++)
+        {
+            put (out, results[i].winShares);
+            put (out, results[i].tieShares);
+            put (out, results[i].equity);
+            put (out, results[i].equity2);
+            putUnits (out, results[i].winUnits);
+            putUnits (out, results[i].tieUnits);
+        }
+        out.flush ();
+        if (!out)
+            throw runtime_error ("EquityCheckpoint, write failed " + tmpname);
+    }
+    if (std::rename (tmpname.c_str(), filename.c_str()) != 0)
+        throw runtime_error ("EquityCheckpoint, can not rename to " + filename);
+}
+
+void EquityCheckpoint::read (const string& filename)
+{
+    std::ifstream in (filename.c_str(), std::ios::binary);
+    if (!in)
+        throw runtime_error ("EquityCheckpoint, can not open " + filename);
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    get (in, magic);
+    get (in, version);
+    if (magic != CHECKPOINT_MAGIC || version != CHECKPOINT_VERSION)
+        throw runtime_error ("EquityCheckpoint, not a checkpoint file " + filename);
+
+    uint64_t ndeck = 0;
+    uint64_t nresults = 0;
+    get (in, fingerprint);
+    get (in, outer);
+    get (in, inner);
+    get (in, live);
+    get (in, ndeck);
+    if (!in || ndeck > 64)
+        throw runtime_error ("EquityCheckpoint, corrupt file " + filename);
+    deck.resize (ndeck);
+    in.read (reinterpret_cast<char*>(&deck[0]), ndeck);
+    get (in, nresults);
+    if (!in || nresults > 64)
+        throw runtime_error ("EquityCheckpoint, corrupt file " + filename);
+    results.assign (nresults, EquityResult());
+    for (size_t i=0; i<results.size(); i++)
+    {
+        get (in, results[i].winShares);
+        get (in, results[i].tieShares);
+        get (in, results[i].equity);
+        get (in, results[i].equity2);
+        getUnits (in, results[i].winUnits);
+        getUnits (in, results[i].tieUnits);
+    }
+    if (!in)
+        throw runtime_error ("EquityCheckpoint, truncated file " + filename);
+}
+
+}
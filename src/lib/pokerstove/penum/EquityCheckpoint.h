@@ -0,0 +1,60 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PENUM_EQUITYCHECKPOINT_H_
+#define PENUM_EQUITYCHECKPOINT_H_
+
+#include <string>
+#include <vector>
+#include <pokerstove/util/utypes.h>
+#include <pokerstove/peval/PokerHandEvaluator.h>
+
+namespace pokerstove
+{
+/**
+ * The saved state of an interrupted ShowdownEnumerator run: where the
+ * enumeration stopped, and the equity accumulated up to that point.
+ *
+ * The position is the rank of the hand tuple in the outer enumeration,
+ * and the rank of the next runout to deal for that tuple.  The order of
+ * the cards in the deck is saved as well, since the runouts are dealt by
+ * position in the deck, and the deck order depends on the history of
+ * the enumeration.
+ *
+ * The file format is a small native endian binary record, it is meant
+ * for resuming on the same kind of machine, not for archiving.
+ */
+struct EquityCheckpoint
+{
+    uint64_t fingerprint;       //!< identifies the query, see ShowdownEnumerator
+    uint64_t outer;             //!< rank of the current hand tuple
+    uint64_t inner;             //!< rank of the next runout for that tuple
+    uint64_t live;              //!< number of live cards in the deck
+    std::vector<uint8_t> deck;  //!< card codes in deck order
+    std::vector<EquityResult> results;
+
+    EquityCheckpoint()
+        : fingerprint(0)
+        , outer(0)
+        , inner(0)
+        , live(0)
+        , deck()
+        , results()
+    {}
+
+    /**
+     * Write the checkpoint to a temporary file and rename it over the
+     * destination, so a reader never sees a partially written file.
+     * Throws std::runtime_error on failure.
+     */
+    void write(const std::string& filename) const;
+
+    /**
+     * Read a checkpoint written by write().  Throws std::runtime_error
+     * if the file can not be read or is not a checkpoint.
+     */
+    void read(const std::string& filename);
+};
+}
+
+#endif  // PENUM_EQUITYCHECKPOINT_H_
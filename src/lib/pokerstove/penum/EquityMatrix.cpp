@@ -0,0 +1,215 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#include "EquityMatrix.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include "BinaryIO.h"
+
+using std::string;
+using std::vector;
+using std::runtime_error;
+
+namespace pokerstove {
+
+using namespace binaryio;
+
+namespace {
+
+const uint32_t MATRIX_MAGIC = 0x4d455350;    // "PSEM"
+const uint32_t MATRIX_VERSION = 1;
+
+// no file holds more hands than every Omaha hand
+const uint64_t MAX_MATRIX_HANDS = 270725;
+
+void putHands (std::ostream& out, const vector<CardSet>& hands)
+{
+    put (out, static_cast<uint64_t>(hands.size()));
+    for (size_t i=0; i<hands.size(); i++)
+        put (out, hands[i].mask());
+}
+
+bool getHands (std::istream& in, vector<CardSet>& hands)
+{
+    uint64_t n = 0;
+    get (in, n);
+    if (!in || n > MAX_MATRIX_HANDS)
+        return false;
+    hands.resize (n);
+    for (size_t i=0; i<hands.size(); i++)
+    {
+        uint64_t mask = 0;
+        get (in, mask);
+        hands[i] = CardSet (mask);
+    }
+    return static_cast<bool>(in);
+}
+
+}
+
+EquityMatrix::EquityMatrix ()
+    : game ()
+    , board ()
+    , _hands0 ()
+    , _hands1 ()
+    , _dense (true)
+    , _pairs ()
+    , _counts ()
+{
+}
+
+EquityMatrix::EquityMatrix (const vector<CardSet>& hands0,
+                            const vector<CardSet>& hands1)
+    : game ()
+    , board ()
+    , _hands0 (hands0)
+    , _hands1 (hands1)
+    , _dense (static_cast<uint64_t>(hands0.size())*hands1.size() <= EQUITY_MATRIX_DENSE_PAIRS)
+    , _pairs ()
+    , _counts ()
+{
+    const Counts zero = {0, 0, 0};
+    if (_dense)
+    {
+        _counts.assign (rows()*cols(), zero);
+        return;
+    }
+    for (size_t i=0; i<rows(); i++)
+        for (size_t j=0; j<cols(); j++)
+            if (!_hands0[i].intersects (_hands1[j]))
+                _pairs.push_back (static_cast<uint64_t>(i)*cols() + j);
+    _counts.assign (_pairs.size(), zero);
+}
+
+EquityMatrix::Counts EquityMatrix::at (size_t i, size_t j) const
+{
+    const uint64_t p = static_cast<uint64_t>(i)*cols() + j;
+    if (_dense)
+        return _counts[p];
+    vector<uint64_t>::const_iterator it = std::lower_bound (_pairs.begin(), _pairs.end(), p);
+    if (it == _pairs.end() || *it != p)
+    {
+        const Counts zero = {0, 0, 0};
+        return zero;
+    }
+    return _counts[it - _pairs.begin()];
+}
+
+vector<EquityResult> EquityMatrix::equity (const vector<double>& weights0,
+                                           const vector<double>& weights1) const
+{
+    if (weights0.size() != rows() || weights1.size() != cols())
+        throw std::invalid_argument ("EquityMatrix, weights do not match the hands");
+
+    // the weight of player 1's hands against each row, once per row
+    double win = 0.0;
+    double lose = 0.0;
+    double tie = 0.0;
+    size_t k = 0;
+    while (k < entries())
+    {
+        const size_t i = row (k);
+        double rowWin = 0.0;
+        double rowLose = 0.0;
+        double rowTie = 0.0;
+        for (; k<entries() && row (k) == i; k++)
+        {
+            const double w = weights1[col (k)];
+            rowWin  += w*_counts[k].win;
+            rowLose += w*_counts[k].lose;
+            rowTie  += w*_counts[k].tie;
+        }
+        win  += weights0[i]*rowWin;
+        lose += weights0[i]*rowLose;
+        tie  += weights0[i]*rowTie;
+    }
+
+    vector<EquityResult> results (2);
+    results[0].winShares = win;
+    results[1].winShares = lose;
+    results[0].tieShares = 0.5*tie;
+    results[1].tieShares = 0.5*tie;
+    return results;
+}
+
+vector<EquityResult> EquityMatrix::equity (const CardDistribution& dist0,
+                                           const CardDistribution& dist1) const
+{
+    vector<double> weights0 (rows());
+    vector<double> weights1 (cols());
+    for (size_t i=0; i<rows(); i++)
+        weights0[i] = dist0[_hands0[i]];
+    for (size_t j=0; j<cols(); j++)
+        weights1[j] = dist1[_hands1[j]];
+    return equity (weights0, weights1);
+}
+
+void EquityMatrix::write (const string& filename) const
+{
+    string tmpname = filename + ".tmp";
+    {
+        std::ofstream out (tmpname.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw runtime_error ("EquityMatrix, can not open " + tmpname);
+
+        put (out, MATRIX_MAGIC);
+        put (out, MATRIX_VERSION);
+        putString (out, game);
+        putString (out, board);
+        putHands (out, _hands0);
+        putHands (out, _hands1);
+        put (out, static_cast<uint8_t>(_dense));
+        put (out, static_cast<uint64_t>(_counts.size()));
+        if (!_dense)
+            out.write (reinterpret_cast<const char*>(_pairs.data()),
+                       _pairs.size()*sizeof(uint64_t));
+        out.write (reinterpret_cast<const char*>(_counts.data()),
+                   _counts.size()*sizeof(Counts));
+        out.flush ();
+        if (!out)
+            throw runtime_error ("EquityMatrix, write failed " + tmpname);
+    }
+    if (std::rename (tmpname.c_str(), filename.c_str()) != 0)
+        throw runtime_error ("EquityMatrix, can not rename to " + filename);
+}
+
+void EquityMatrix::read (const string& filename)
+{
+    std::ifstream in (filename.c_str(), std::ios::binary);
+    if (!in)
+        throw runtime_error ("EquityMatrix, can not open " + filename);
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    get (in, magic);
+    get (in, version);
+    if (magic != MATRIX_MAGIC || version != MATRIX_VERSION)
+        throw runtime_error ("EquityMatrix, not an equity matrix file " + filename);
+
+    if (!getString (in, game) || !getString (in, board) ||
+        !getHands (in, _hands0) || !getHands (in, _hands1))
+        throw runtime_error ("EquityMatrix, corrupt file " + filename);
+    uint8_t isDense = 0;
+    uint64_t nentries = 0;
+    get (in, isDense);
+    get (in, nentries);
+    _dense = isDense != 0;
+    const uint64_t npairs = static_cast<uint64_t>(rows())*cols();
+    if (!in || (_dense && nentries != npairs) || nentries > npairs)
+        throw runtime_error ("EquityMatrix, corrupt file " + filename);
+    _pairs.assign (_dense ? 0 : nentries, 0);
+    _counts.resize (nentries);
+    if (!_dense)
+        in.read (reinterpret_cast<char*>(_pairs.data()), _pairs.size()*sizeof(uint64_t));
+    in.read (reinterpret_cast<char*>(_counts.data()), _counts.size()*sizeof(Counts));
+    if (!in)
+        throw runtime_error ("EquityMatrix, truncated file " + filename);
+    for (size_t k=0; k<_pairs.size(); k++)
+        if (_pairs[k] >= npairs || (k > 0 && _pairs[k] <= _pairs[k-1]))
+            throw runtime_error ("EquityMatrix, corrupt file " + filename);
+}
+
+}
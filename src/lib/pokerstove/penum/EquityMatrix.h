@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PENUM_EQUITYMATRIX_H_
+#define PENUM_EQUITYMATRIX_H_
+
+#include <string>
+#include <vector>
+#include <pokerstove/util/utypes.h>
+#include <pokerstove/peval/PokerHandEvaluator.h>
+#include "CardDistribution.h"
+
+namespace pokerstove
+{
+/**
+ * Matrices of at most this many pairs are stored densely, enough for
+ * every hold'em hand against every other, 1326x1326.
+ */
+const uint64_t EQUITY_MATRIX_DENSE_PAIRS = UINT64_C(1326)*1326;
+
+/**
+ * The heads up showdowns of every hand of one distribution against every
+ * hand of another, each pair counted with weight one.  Entry (i,j) holds
+ * the runouts hand i of the first distribution wins, loses and ties
+ * against hand j of the second.  The equity of any weighting of the two
+ * distributions is then a matrix-vector product, see equity(), with no
+ * new enumeration.
+ *
+ * Pairs of hands which share a card have no showdowns.  Up to
+ * EQUITY_MATRIX_DENSE_PAIRS pairs the counts are kept for every pair in
+ * row major order, and past that only for the pairs which share no
+ * card, in row major order along with their positions.
+ *
+ * The file format is native endian binary, like PartialEquity.
+ */
+class EquityMatrix
+{
+public:
+    struct Counts
+    {
+        uint32_t win;
+        uint32_t lose;
+        uint32_t tie;
+    };
+
+    EquityMatrix ();
+
+    /**
+     * a matrix of zero counts for the hands in positions of the two
+     * distributions
+     */
+    EquityMatrix (const std::vector<CardSet>& hands0,
+                  const std::vector<CardSet>& hands1);
+
+    size_t rows () const                     { return _hands0.size(); }
+    size_t cols () const                     { return _hands1.size(); }
+    bool dense () const                      { return _dense; }
+
+    /**
+     * the hands of the rows, player 0, or of the columns, player 1
+     */
+    const std::vector<CardSet>& hands (size_t player) const
+    {
+        return player == 0 ? _hands0 : _hands1;
+    }
+
+    /**
+     * the counts of hand i against hand j, zero when they share a card
+     */
+    Counts at (size_t i, size_t j) const;
+
+    /**
+     * The entries are the pairs with stored counts, in row major order.
+     * The counts of entry k are for hand row(k) against hand col(k).
+     */
+    size_t entries () const                  { return _counts.size(); }
+    size_t row (size_t k) const              { return static_cast<size_t>(pair(k) / cols()); }
+    size_t col (size_t k) const              { return static_cast<size_t>(pair(k) % cols()); }
+    Counts& operator[] (size_t k)            { return _counts[k]; }
+    const Counts& operator[] (size_t k) const { return _counts[k]; }
+
+    /**
+     * The equity of the two players with the hands weighted by position,
+     * as ShowdownEnumerator::calculateEquity gives for the distributions
+     * with those weights.  Throws std::invalid_argument if the sizes do
+     * not match.
+     */
+    std::vector<EquityResult> equity (const std::vector<double>& weights0,
+                                      const std::vector<double>& weights1) const;
+
+    /**
+     * The equity with each hand weighted as in the distributions, hands
+     * missing from a distribution count for nothing.
+     */
+    std::vector<EquityResult> equity (const CardDistribution& dist0,
+                                      const CardDistribution& dist1) const;
+
+    /**
+     * Write the matrix, atomically as for EquityCheckpoint.  Throws
+     * std::runtime_error on failure.
+     */
+    void write (const std::string& filename) const;
+
+    /**
+     * Read a matrix written by write().  Throws std::runtime_error if the
+     * file can not be read.
+     */
+    void read (const std::string& filename);
+
+    std::string game;           //!< evaluator description
+    std::string board;
+
+private:
+    uint64_t pair (size_t k) const
+    {
+        return _dense ? k : _pairs[k];
+    }
+
+    std::vector<CardSet> _hands0;
+    std::vector<CardSet> _hands1;
+    bool _dense;
+    std::vector<uint64_t> _pairs;   // i*cols+j of each entry, sparse only
+    std::vector<Counts> _counts;
+};
+}
+
+#endif  // PENUM_EQUITYMATRIX_H_
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "EquityMatrix.h"
+#include "ShowdownEnumerator.h"
+
+using namespace pokerstove;
+using namespace std;
+
+namespace {
+
+void expectSameResults(const vector<EquityResult>& expected,
+                       const vector<EquityResult>& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i=0; i<expected.size(); i++)
+    {
+        EXPECT_NEAR(expected[i].winShares, actual[i].winShares,
+                    1e-9*expected[i].winShares);
+        EXPECT_NEAR(expected[i].tieShares, actual[i].tieShares,
+                    1e-9*expected[i].tieShares);
+    }
+}
+
+/**
+ * The matrix gives calculateEquity for the distributions, and for new
+ * weights on the same hands, and survives the round trip to disk.
+ */
+void expectMatrixMatches(const string& game,
+                         vector<CardDistribution> dists,
+                         const string& board,
+                         bool dense)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc(game);
+    ShowdownEnumerator showdown;
+    EquityMatrix matrix = showdown.calculateMatrix(dists, CardSet(board), peval);
+    EXPECT_EQ(dense, matrix.dense());
+    EXPECT_EQ(dists[0].size(), matrix.rows());
+    EXPECT_EQ(dists[1].size(), matrix.cols());
+    expectSameResults(showdown.calculateEquity(dists, CardSet(board), peval),
+                      matrix.equity(dists[0], dists[1]));
+
+    // every third hand of player 0 counts three times as much, and the
+    // first hand of player 1 is dropped
+    for (size_t i=0; i<dists[0].size(); i+=3)
+        dists[0][dists[0][i]] = 3.0;
+    dists[1][dists[1][0]] = 0.0;
+    expectSameResults(showdown.calculateEquity(dists, CardSet(board), peval),
+                      matrix.equity(dists[0], dists[1]));
+
+    const string filename = "EquityMatrix." + game + ".matrix";
+    matrix.write(filename);
+    EquityMatrix reread;
+    reread.read(filename);
+    std::remove(filename.c_str());
+    EXPECT_EQ(matrix.dense(), reread.dense());
+    EXPECT_EQ(matrix.entries(), reread.entries());
+    EXPECT_EQ(peval->str(), reread.game);
+    EXPECT_EQ(CardSet(board).str(), reread.board);
+    expectSameResults(matrix.equity(dists[0], dists[1]),
+                      reread.equity(dists[0], dists[1]));
+}
+
+}
+
+TEST(EquityMatrix, HoldemRanges)
+{
+    vector<CardDistribution> dists(2);
+    dists[0].parse("AsAh,AcAd,KdKh,AsKs,AhKh,7c7d");
+    dists[1].parse("KsKh,QcQd,JhJs,AsKs,AdKd,8c9c");
+    expectMatrixMatches("h", dists, "7h8d9h", true);
+
+    // hands which share a card have no showdowns
+    ShowdownEnumerator showdown;
+    EquityMatrix matrix = showdown.calculateMatrix(dists, CardSet("7h8d9h2c"),
+                                                   PokerHandEvaluator::alloc("h"));
+    EquityMatrix::Counts counts = matrix.at(3, 3);
+    EXPECT_EQ(0, counts.win + counts.lose + counts.tie);
+    counts = matrix.at(0, 1);
+    EXPECT_EQ(44, counts.win + counts.lose + counts.tie);
+}
+
+TEST(EquityMatrix, EveryHoldemHand)
+{
+    vector<CardDistribution> dists(2);
+    dists[0].fill(2);
+    dists[1].fill(2);
+    expectMatrixMatches("h", dists, "7h8d9hTsJs", true);
+}
+
+TEST(EquityMatrix, SparseOmaha)
+{
+    // 1365 hands a side is past the dense size
+    vector<CardDistribution> dists(2);
+    dists[0].fill(CardSet("AcKcQcJcTcAdKdQdJdTdAhKhQhJhTh"), 4);
+    dists[1] = dists[0];
+    expectMatrixMatches("O", dists, "2c3d4h5s9s", false);
+}
+
+TEST(EquityMatrix, RejectsMultiway)
+{
+    vector<CardDistribution> dists(3);
+    for (size_t i=0; i<dists.size(); i++)
+        dists[i].parse(".");
+    ShowdownEnumerator showdown;
+    EXPECT_THROW(showdown.calculateMatrix(dists, CardSet(), PokerHandEvaluator::alloc("h")),
+                 std::runtime_error);
+    dists.pop_back();
+    EXPECT_THROW(showdown.calculateMatrix(dists, CardSet(), PokerHandEvaluator::alloc("h")),
+                 std::invalid_argument);
+}
@@ -0,0 +1,211 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#include "HoldemHeadsUp.h"
+
+#include <stdexcept>
+#include <pokerstove/peval/Holdem.h>
+#include <pokerstove/peval/PokerEvaluation.h>
+
+namespace pokerstove {
+
+namespace {
+
+const int NUM_CARDS = 52;
+const int NUM_RANKS = 13;
+const int NUM_SUITS = 4;
+const uint64_t SUIT_MASK = 0x1fff;
+
+/**
+ * The live cards, ordered by rank so the cards of a rank are together.
+ */
+struct LiveCards
+{
+    uint64_t mask[NUM_CARDS];
+    int suit[NUM_CARDS];
+    int rank[NUM_CARDS];
+    int n;
+};
+
+inline int showdown(uint64_t mask0, uint64_t mask1)
+{
+    PokerEvaluation e0 = CardSet(mask0).evaluateHigh();
+    PokerEvaluation e1 = CardSet(mask1).evaluateHigh();
+    return (e0 > e1) - (e0 < e1);
+}
+
+inline void count(int outcome, uint64_t times, HeadsUpCounts& counts)
+{
+    if (outcome > 0)
+        counts.win += times;
+    else if (outcome < 0)
+        counts.lose += times;
+    else
+        counts.tie += times;
+}
+
+/**
+ * The suits where the last ncards board cards can change a flush, those
+ * where either hand with the board has 5-ncards or more cards.  Cards of
+ * the other suits only count for their ranks, so cards of one rank in
+ * those suits are interchangeable.
+ */
+inline int flushSuits(uint64_t mask0, uint64_t mask1, int ncards)
+{
+    int suits = 0;
+    for (int s=0; s<NUM_SUITS; s++)
+    {
+        const int shift = s*NUM_RANKS;
+        if (countbits((mask0 >> shift) & SUIT_MASK) + ncards >= 5 ||
+                countbits((mask1 >> shift) & SUIT_MASK) + ncards >= 5)
+            suits |= 1 << s;
+    }
+    return suits;
+}
+
+/**
+ * Deal K more board cards from live[start..n), in increasing order, on top
+ * of each hand with the board so far.
+ */
+template <int K>
+struct Deal
+{
+    static void cards(const LiveCards& live, int start,
+                      uint64_t mask0, uint64_t mask1, HeadsUpCounts& counts)
+    {
+        for (int i=start; i<=live.n-K; i++)
+            Deal<K-1>::cards(live, i+1, mask0|live.mask[i], mask1|live.mask[i], counts);
+    }
+};
+
+/**
+ * The turn and the river.  The live cards are split into those of the
+ * flush suits, which are dealt one by one, and the rest, which are dealt
+ * by rank with the number of cards of the rank as a multiplier.
+ */
+template <>
+struct Deal<2>
+{
+    static void cards(const LiveCards& live, int start,
+                      uint64_t mask0, uint64_t mask1, HeadsUpCounts& counts)
+    {
+        const int suits = flushSuits(mask0, mask1, 2);
+        uint64_t flush[NUM_CARDS];
+        int nflush = 0;
+        uint64_t first[NUM_RANKS];
+        uint64_t second[NUM_RANKS];
+        uint64_t nrank[NUM_RANKS] = {0};
+        for (int i=start; i<live.n; i++)
+        {
+            if (suits & (1 << live.suit[i]))
+            {
+                flush[nflush++] = live.mask[i];
+                continue;
+            }
+            const int r = live.rank[i];
+            if (nrank[r] == 0)
+                first[r] = live.mask[i];
+            else if (nrank[r] == 1)
+                second[r] = live.mask[i];
+            nrank[r]++;
+        }
+
+        for (int a=0; a<nflush; a++)
+        {
+            const uint64_t m0 = mask0|flush[a];
+            const uint64_t m1 = mask1|flush[a];
+            for (int b=a+1; b<nflush; b++)
+                count(showdown(m0|flush[b], m1|flush[b]), 1, counts);
+            for (int r=0; r<NUM_RANKS; r++)
+                if (nrank[r] > 0)
+                    count(showdown(m0|first[r], m1|first[r]), nrank[r], counts);
+        }
+        for (int r=0; r<NUM_RANKS; r++)
+        {
+            if (nrank[r] == 0)
+                continue;
+            const uint64_t m0 = mask0|first[r];
+            const uint64_t m1 = mask1|first[r];
+            if (nrank[r] > 1)
+                count(showdown(m0|second[r], m1|second[r]), nrank[r]*(nrank[r]-1)/2, counts);
+            for (int q=r+1; q<NUM_RANKS; q++)
+                if (nrank[q] > 0)
+                    count(showdown(m0|first[q], m1|first[q]), nrank[r]*nrank[q], counts);
+        }
+    }
+};
+
+/**
+ * The river.  Rivers of one rank in suits where no flush can change give
+ * the same showdown, so that is evaluated once for all of them.
+ */
+template <>
+struct Deal<1>
+{
+    static void cards(const LiveCards& live, int start,
+                      uint64_t mask0, uint64_t mask1, HeadsUpCounts& counts)
+    {
+        const int suits = flushSuits(mask0, mask1, 1);
+        int i = start;
+        while (i < live.n)
+        {
+            const int rank = live.rank[i];
+            int same = -1;
+            uint64_t times = 0;
+            for (; i<live.n && live.rank[i] == rank; i++)
+            {
+                if (suits & (1 << live.suit[i]))
+                    count(showdown(mask0|live.mask[i], mask1|live.mask[i]), 1, counts);
+                else if (times++ == 0)
+                    same = i;
+            }
+            if (times > 0)
+                count(showdown(mask0|live.mask[same], mask1|live.mask[same]), times, counts);
+        }
+    }
+};
+
+}
+
+HeadsUpCounts enumerateHeadsUp(const CardSet& hand0,
+                               const CardSet& hand1,
+                               const CardSet& board)
+{
+    if (hand0.size() != NUM_HOLDEM_POCKET || hand1.size() != NUM_HOLDEM_POCKET ||
+            board.size() > BOARD_SIZE)
+        throw std::invalid_argument("enumerateHeadsUp: hands need two cards, boards at most five");
+    if (hand0.intersects(hand1) || hand0.intersects(board) || hand1.intersects(board))
+        throw std::invalid_argument("enumerateHeadsUp: hands and board share cards");
+
+    // rank major order, so the river loop meets the cards of a rank together
+    const uint64_t dead = (hand0 | hand1 | board).mask();
+    LiveCards live;
+    live.n = 0;
+    for (int r=0; r<NUM_RANKS; r++)
+        for (int s=0; s<NUM_SUITS; s++)
+        {
+            const uint64_t card = UINT64_C(1) << (s*NUM_RANKS + r);
+            if (dead & card)
+                continue;
+            live.mask[live.n] = card;
+            live.suit[live.n] = s;
+            live.rank[live.n] = r;
+            live.n++;
+        }
+
+    const uint64_t mask0 = (hand0 | board).mask();
+    const uint64_t mask1 = (hand1 | board).mask();
+    HeadsUpCounts counts;
+    switch (BOARD_SIZE - board.size())
+    {
+        case 0: count(showdown(mask0, mask1), 1, counts); break;
+        case 1: Deal<1>::cards(live, 0, mask0, mask1, counts); break;
+        case 2: Deal<2>::cards(live, 0, mask0, mask1, counts); break;
+        case 3: Deal<3>::cards(live, 0, mask0, mask1, counts); break;
+        case 4: Deal<4>::cards(live, 0, mask0, mask1, counts); break;
+        case 5: Deal<5>::cards(live, 0, mask0, mask1, counts); break;
+    }
+    return counts;
+}
+
+}
@@ -0,0 +1,48 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PENUM_HOLDEMHEADSUP_H_
+#define PENUM_HOLDEMHEADSUP_H_
+
+#include <pokerstove/util/utypes.h>
+#include <pokerstove/peval/CardSet.h>
+
+namespace pokerstove
+{
+/**
+ * The showdowns of one hold'em hand against another, counted over every
+ * completion of the board, from the first hand's point of view.
+ */
+struct HeadsUpCounts
+{
+    uint64_t win;
+    uint64_t tie;
+    uint64_t lose;
+
+    HeadsUpCounts()
+        : win(0)
+        , tie(0)
+        , lose(0)
+    {}
+
+    uint64_t total() const
+    {
+        return win + tie + lose;
+    }
+};
+
+/**
+ * Enumerate every board which completes board for two complete hold'em
+ * hands.  This is the two player special case of ShowdownEnumerator: the
+ * board cards are dealt in nested loops from the live cards, the masks
+ * of the board so far and of each hand with it are built up one card per
+ * loop, and the showdowns are counted in integers.  The hands and board
+ * must be disjoint, with two cards in each hand and at most five on the
+ * board, or std::invalid_argument is thrown.
+ */
+HeadsUpCounts enumerateHeadsUp(const CardSet& hand0,
+                               const CardSet& hand1,
+                               const CardSet& board);
+}
+
+#endif  // PENUM_HOLDEMHEADSUP_H_
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <pokerstove/peval/HoldemHandEvaluator.h>
+#include "HoldemHeadsUp.h"
+#include "ShowdownEnumerator.h"
+
+using namespace pokerstove;
+using namespace std;
+
+namespace {
+
+/**
+ * A hold'em evaluator the enumerator does not recognize, and which does
+ * not say when the suits can be ignored, so every tuple is dealt card by
+ * card rather than by enumerateHeadsUp or by rank patterns.
+ */
+class GeneralHoldemEvaluator : public HoldemHandEvaluator
+{
+public:
+    virtual size_t flushSize() const { return 0; }
+};
+
+void expectSameCounts(const string& hand0, const string& hand1, const string& board)
+{
+    vector<CardDistribution> dists(2);
+    dists[0].parse(hand0);
+    dists[1].parse(hand1);
+    ShowdownEnumerator showdown;
+    boost::shared_ptr<PokerHandEvaluator> general(new GeneralHoldemEvaluator);
+    vector<EquityResult> expected = showdown.calculateEquity(dists, CardSet(board), general);
+
+    HeadsUpCounts counts = enumerateHeadsUp(CardSet(hand0), CardSet(hand1), CardSet(board));
+    EXPECT_EQ(expected[0].winShares, counts.win) << hand0 << " " << hand1 << " " << board;
+    EXPECT_EQ(expected[1].winShares, counts.lose) << hand0 << " " << hand1 << " " << board;
+    EXPECT_EQ(expected[0].tieShares, 0.5*counts.tie) << hand0 << " " << hand1 << " " << board;
+}
+
+}
+
+TEST(HoldemHeadsUp, MatchesShowdownEnumerator)
+{
+    expectSameCounts("AcKd", "QhJs", "");
+    expectSameCounts("AsKs", "QsJs", "2s7d");
+    expectSameCounts("AcKd", "QhJs", "2c7d9h");
+    expectSameCounts("7h6h", "AcAh", "2h8h9c");
+    expectSameCounts("AsKs", "QhQd", "Ts9s8d2s");
+    expectSameCounts("AsKd", "AhKc", "2c3c4c5c");
+    expectSameCounts("AsKd", "AhKc", "2c3c4c5c6c");
+}
+
+TEST(HoldemHeadsUp, CountsEveryBoard)
+{
+    HeadsUpCounts counts = enumerateHeadsUp(CardSet("AcAd"), CardSet("KcKd"), CardSet());
+    EXPECT_EQ(1712304, counts.total());
+}
+
+TEST(HoldemHeadsUp, RejectsBadHands)
+{
+    EXPECT_THROW(enumerateHeadsUp(CardSet("AcAd"), CardSet("AcKd"), CardSet()),
+                 std::invalid_argument);
+    EXPECT_THROW(enumerateHeadsUp(CardSet("AcAdAh"), CardSet("KcKd"), CardSet()),
+                 std::invalid_argument);
+    EXPECT_THROW(enumerateHeadsUp(CardSet("AcAd"), CardSet("KcKd"), CardSet("2c3c4c5c6c7c")),
+                 std::invalid_argument);
+}
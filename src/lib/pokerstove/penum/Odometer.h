@@ -5,6 +5,7 @@
 #ifndef COMMON_ENUM_ODOMETER_H_
 #define COMMON_ENUM_ODOMETER_H_
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <algorithm>
@@ -42,6 +43,10 @@
  * To check if more tuples are available, call hasMore() and to get the
  * next one, call getNext ().
  *
+ * The tuples are numbered in this order from zero to count()-1, and
+ * seek(rank) jumps directly to a tuple by number, which allows a range
+ * of tuples to be processed without walking the ones before it.
+ *
  * usage example:
  */
 class Odometer
@@ -71,6 +76,30 @@ public:
         return ret;
     }
 
+    /**
+     * the number of tuples in the enumeration
+     */
+    uint64_t count () const
+    {
+        uint64_t ret = 1;
+        for (size_t i=0; i<_extents.size(); i++)
+            ret *= _extents[i];
+        return ret;
+    }
+
+    /**
+     * jump to the tuple with the given rank, the last index is the least
+     * significant digit
+     */
+    void seek (uint64_t rank)
+    {
+        for (int i=static_cast<int>(_odom.size())-1; i>=0; i--)
+        {
+            _odom[i] = static_cast<int>(rank % _extents[i]);
+            rank /= _extents[i];
+        }
+    }
+
     bool next ()
     {
         return flip (static_cast<int>(_odom.size()-1));
@@ -100,4 +129,119 @@ private:
     std::vector<int> _odom;
 };
 
+/** A reflected mixed-radix Gray code odometer.  It visits the same tuples
+ * as the Odometer, but in an order where each call to next() changes
+ * exactly one index by one.  For the extents <2,3> the order is:
+ *
+ *  0  0
+ *  0  1
+ *  0  2
+ *  1  2
+ *  1  1
+ *  1  0
+ *
+ * After a successful next(), changed() is the index which moved and
+ * previous() is the value it held before.  This lets clients which cache
+ * work per index update only the one slot that moved.
+ */
+class GrayOdometer
+{
+public:
+    explicit GrayOdometer (const std::vector<size_t> & extents)
+        : _extents(extents.size())
+        , _odom(extents.size(),0)
+        , _dirs(extents.size(),1)
+        , _changed(0)
+        , _previous(0)
+    {
+        for (size_t i=0; i<extents.size(); i++)
+            _extents[i] = static_cast<int>(extents[i]);
+    }
+
+    size_t size () const
+    {
+        return _odom.size();
+    }
+
+    std::string str() const
+    {
+        std::string ret(size(),'0');
+        for (size_t i=0; i<ret.size(); i++)
+            ret[i] += _odom[i];
+        return ret;
+    }
+
+    /**
+     * Move to the next tuple, the last index moves fastest.  Indices
+     * which can not move in their current direction reverse it, which
+     * takes amortized constant time per call.
+     */
+    bool next ()
+    {
+        for (int n=static_cast<int>(_odom.size())-1; n>=0; n--)
+        {
+            int val = _odom[n] + _dirs[n];
+            if (val >= 0 && val < _extents[n])
+            {
+                _changed = static_cast<size_t>(n);
+                _previous = _odom[n];
+                _odom[n] = val;
+                return true;
+            }
+            _dirs[n] = -_dirs[n];
+        }
+        return false;
+    }
+
+    uint64_t count () const
+    {
+        uint64_t ret = 1;
+        for (size_t i=0; i<_extents.size(); i++)
+            ret *= _extents[i];
+        return ret;
+    }
+
+    /**
+     * Jump to the tuple with the given rank in the Gray code order.  An
+     * index is reflected when the tuple of the indices before it, read
+     * as a mixed radix number, is odd.  The directions are set so that
+     * next() continues from here.
+     */
+    void seek (uint64_t rank)
+    {
+        uint64_t weight = 1;  // product of the extents after index i
+        for (int i=static_cast<int>(_odom.size())-1; i>=0; i--)
+        {
+            uint64_t quotient = rank / weight;
+            int digit = static_cast<int>(quotient % _extents[i]);
+            bool reflected = (quotient / _extents[i]) % 2 == 1;
+            _odom[i] = reflected ? _extents[i]-1-digit : digit;
+            _dirs[i] = reflected ? -1 : 1;
+            weight *= _extents[i];
+        }
+    }
+
+    size_t changed () const
+    {
+        return _changed;
+    }
+
+    unsigned int previous () const
+    {
+        return _previous;
+    }
+
+    unsigned int operator[](size_t i) const
+    {
+        return _odom[i];
+    }
+
+private:
+    std::vector<int> _extents;
+    std::vector<int> _odom;
+    std::vector<int> _dirs;
+    size_t _changed;
+    unsigned int _previous;
+};
+
 #endif  // COMMON_ENUM_ODOMETER_H_
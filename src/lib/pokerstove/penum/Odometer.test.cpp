@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <vector>
+#include "Odometer.h"
+
+using namespace std;
+
+TEST(Odometer, VisitsAllTuples) {
+    vector<size_t> extents = {2, 4, 3};
+    Odometer o(extents);
+    int visits = 0;
+    do {
+        visits++;
+    }
+    while (o.next());
+    EXPECT_EQ(24, visits);
+}
+
+TEST(GrayOdometer, VisitsAllTuplesOnce) {
+    vector<size_t> extents = {2, 4, 1, 3};
+    GrayOdometer o(extents);
+    set<string> seen;
+    seen.insert(o.str());
+    while (o.next()) {
+        EXPECT_TRUE(seen.insert(o.str()).second);
+    }
+    EXPECT_EQ(24, seen.size());
+}
+
+TEST(GrayOdometer, OneIndexChangesPerStep) {
+    vector<size_t> extents = {3, 2, 4};
+    GrayOdometer o(extents);
+    vector<unsigned int> last = {o[0], o[1], o[2]};
+    while (o.next()) {
+        size_t moved = 0;
+        for (size_t i=0; i<o.size(); i++) {
+            if (o[i] != last[i]) {
+                moved++;
+                EXPECT_EQ(i, o.changed());
+                EXPECT_EQ(last[i], o.previous());
+                EXPECT_EQ(1, abs(static_cast<int>(o[i]) - static_cast<int>(last[i])));
+            }
+            last[i] = o[i];
+        }
+        EXPECT_EQ(1, moved);
+    }
+}
+
+TEST(Odometer, SeekMatchesNext) {
+    vector<size_t> extents = {2, 4, 1, 3};
+    Odometer o(extents);
+    EXPECT_EQ(24, o.count());
+    uint64_t rank = 0;
+    do {
+        Odometer jump(extents);
+        jump.seek(rank++);
+        EXPECT_EQ(o.str(), jump.str());
+    }
+    while (o.next());
+    EXPECT_EQ(o.count(), rank);
+}
+
+TEST(GrayOdometer, SeekMatchesNext) {
+    vector<size_t> extents = {3, 1, 2, 4};
+    GrayOdometer o(extents);
+    EXPECT_EQ(24, o.count());
+    uint64_t rank = 0;
+    do {
+        GrayOdometer jump(extents);
+        jump.seek(rank++);
+        EXPECT_EQ(o.str(), jump.str());
+
+        // continuing from a seek gives the same sequence
+        GrayOdometer walk(o);
+        while (walk.next()) {
+            ASSERT_TRUE(jump.next());
+            EXPECT_EQ(walk.str(), jump.str());
+            EXPECT_EQ(walk.changed(), jump.changed());
+        }
+        EXPECT_FALSE(jump.next());
+    }
+    while (o.next());
+    EXPECT_EQ(o.count(), rank);
+}
@@ -0,0 +1,169 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#include "PartialEquity.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <boost/lexical_cast.hpp>
+#include "BinaryIO.h"
+
+using std::string;
+using std::vector;
+using std::runtime_error;
+
+namespace pokerstove {
+
+using namespace binaryio;
+
+namespace {
+
+const uint32_t PARTIAL_MAGIC = 0x50455350;    // "PSEP"
+const uint32_t PARTIAL_VERSION = 2;
+
+bool byBegin (const PartialEquity& a, const PartialEquity& b)
+{
+    return a.begin < b.begin;
+}
+
+}
+
+void PartialEquity::write (const string& filename) const
+{
+    string tmpname = filename + ".tmp";
+    {
+        std::ofstream out (tmpname.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw runtime_error ("PartialEquity, can not open " + tmpname);
+
+        put (out, PARTIAL_MAGIC);
+        put (out, PARTIAL_VERSION);
+        put (out, fingerprint);
+        put (out, shard);
+        put (out, nshards);
+        put (out, begin);
+        put (out, end);
+        put (out, total);
+        put (out, static_cast<uint8_t>(exact));
+        putString (out, game);
+        putString (out, board);
+        put (out, static_cast<uint64_t>(hands.size()));
+        for (size_t i=0; i<hands.size(); i++)
+            putString (out, hands[i]);
+        put (out, static_cast<uint64_t>(results.size()));
+        for (size_t i=0; i<results.size(); i++)
+        {
+            put (out, results[i].winShares);
+            put (out, results[i].tieShares);
+            put (out, results[i].equity);
+            put (out, results[i].equity2);
+            putUnits (out, results[i].winUnits);
+            putUnits (out, results[i].tieUnits);
+        }
+        out.flush ();
+        if (!out)
+            throw runtime_error ("PartialEquity, write failed " + tmpname);
+    }
+    if (std::rename (tmpname.c_str(), filename.c_str()) != 0)
+        throw runtime_error ("PartialEquity, can not rename to " + filename);
+}
+
+void PartialEquity::read (const string& filename)
+{
+    std::ifstream in (filename.c_str(), std::ios::binary);
+    if (!in)
+        throw runtime_error ("PartialEquity, can not open " + filename);
+
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    get (in, magic);
+    get (in, version);
+    if (magic != PARTIAL_MAGIC || version != PARTIAL_VERSION)
+        throw runtime_error ("PartialEquity, not a partial result file " + filename);
+
+    uint64_t nhands = 0;
+    uint64_t nresults = 0;
+    get (in, fingerprint);
+    get (in, shard);
+    get (in, nshards);
+    get (in, begin);
+    get (in, end);
+    get (in, total);
+    uint8_t isExact = 0;
+    get (in, isExact);
+    exact = isExact != 0;
+    if (!getString (in, game) || !getString (in, board))
+        throw runtime_error ("PartialEquity, corrupt file " + filename);
+    get (in, nhands);
+    if (!in || nhands > 64)
+        throw runtime_error ("PartialEquity, corrupt file " + filename);
+    hands.resize (nhands);
+    for (size_t i=0; i<hands.size(); i++)
+        if (!getString (in, hands[i]))
+            throw runtime_error ("PartialEquity, corrupt file " + filename);
+    get (in, nresults);
+    if (!in || nresults > 64)
+        throw runtime_error ("PartialEquity, corrupt file " + filename);
+    results.assign (nresults, EquityResult());
+    for (size_t i=0; i<results.size(); i++)
+    {
+        get (in, results[i].winShares);
+        get (in, results[i].tieShares);
+        get (in, results[i].equity);
+        get (in, results[i].equity2);
+        getUnits (in, results[i].winUnits);
+        getUnits (in, results[i].tieUnits);
+    }
+    if (!in)
+        throw runtime_error ("PartialEquity, truncated file " + filename);
+}
+
+PartialEquity PartialEquity::merge (const vector<PartialEquity>& shards)
+{
+    if (shards.empty())
+        throw runtime_error ("PartialEquity::merge, no shards");
+
+    vector<PartialEquity> sorted (shards);
+    std::sort (sorted.begin(), sorted.end(), byBegin);
+    const PartialEquity& first = sorted[0];
+    if (sorted.size() != first.nshards)
+        throw runtime_error ("PartialEquity::merge, expected "
+                             + boost::lexical_cast<string>(first.nshards) + " shards, got "
+                             + boost::lexical_cast<string>(sorted.size()));
+
+    PartialEquity ret (first);
+    ret.shard = 0;
+    ret.begin = 0;
+    ret.end = 0;
+    ret.results.assign (first.results.size(), EquityResult());
+    for (size_t i=0; i<sorted.size(); i++)
+    {
+        const PartialEquity& part = sorted[i];
+        if (part.fingerprint != first.fingerprint ||
+            part.nshards != first.nshards ||
+            part.total != first.total ||
+            part.exact != first.exact ||
+            part.results.size() != first.results.size())
+            throw runtime_error ("PartialEquity::merge, shard "
+                                 + boost::lexical_cast<string>(part.shard)
+                                 + " is from a different query");
+        if (part.begin != ret.end)
+            throw runtime_error ("PartialEquity::merge, shards do not cover runouts "
+                                 + boost::lexical_cast<string>(ret.end) + " to "
+                                 + boost::lexical_cast<string>(part.begin) + " exactly once");
+        ret.end = part.end;
+        for (size_t j=0; j<ret.results.size(); j++)
+            ret.results[j] += part.results[j];
+    }
+    if (ret.end != ret.total)
+        throw runtime_error ("PartialEquity::merge, shards stop short of the last runout");
+    if (ret.exact)
+        for (size_t j=0; j<ret.results.size(); j++)
+            ret.results[j].setExactShares ();
+    ret.nshards = 1;
+    return ret;
+}
+
+}
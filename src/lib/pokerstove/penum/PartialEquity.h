@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PENUM_PARTIALEQUITY_H_
+#define PENUM_PARTIALEQUITY_H_
+
+#include <string>
+#include <vector>
+#include <pokerstove/util/utypes.h>
+#include <pokerstove/peval/PokerHandEvaluator.h>
+
+namespace pokerstove
+{
+/**
+ * The results of one shard of a ShowdownEnumerator run.  The runouts of
+ * a query are numbered from zero to total, hand tuple by hand tuple, and
+ * shard i of n covers the runouts [begin,end) of that numbering.  The
+ * partial results of all n shards add up to the full results, exactly
+ * so when the shards count exact shares.
+ *
+ * The file format is native endian binary, like EquityCheckpoint.
+ */
+struct PartialEquity
+{
+    uint64_t fingerprint;       //!< identifies the query, the same for every shard
+    uint64_t shard;             //!< index of this shard
+    uint64_t nshards;           //!< number of shards in the split
+    uint64_t begin;             //!< first runout in this shard
+    uint64_t end;               //!< one past the last runout
+    uint64_t total;             //!< runouts in the whole query
+    bool exact;                 //!< results carry exact share counts
+    std::string game;           //!< evaluator description
+    std::string board;
+    std::vector<std::string> hands;  //!< distributions, callers may put their own descriptions
+    std::vector<EquityResult> results;
+
+    PartialEquity()
+        : fingerprint(0)
+        , shard(0)
+        , nshards(1)
+        , begin(0)
+        , end(0)
+        , total(0)
+        , exact(false)
+        , game()
+        , board()
+        , hands()
+        , results()
+    {}
+
+    /**
+     * Write the partial results, atomically as for EquityCheckpoint.
+     * Throws std::runtime_error on failure.
+     */
+    void write(const std::string& filename) const;
+
+    /**
+     * Read partial results written by write().  Throws
+     * std::runtime_error if the file can not be read.
+     */
+    void read(const std::string& filename);
+
+    /**
+     * Add up the shards of one query.  Throws std::runtime_error unless
+     * the shards are all from the same query and split, and together
+     * cover every runout exactly once.
+     */
+    static PartialEquity merge(const std::vector<PartialEquity>& shards);
+};
+}
+
+#endif  // PENUM_PARTIALEQUITY_H_
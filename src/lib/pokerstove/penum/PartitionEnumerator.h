@@ -41,6 +41,11 @@ typedef combinations Combos;
 /**
  * this class enumerates over all partistions of a set of data
  * *given* the size of the partitions.
+ *
+ * The partitions are numbered in enumeration order from zero to
+ * count()-1.  Each part is a digit in a mixed radix number, the last part
+ * being the least significant, with one combination of the remaining
+ * indices per value, so seek(rank) can jump to any partition directly.
  */
 class PartitionEnumerator2
 {
@@ -153,6 +158,59 @@ public:
         return incr ();
     }
 
+    /**
+     * Move to the first partition which differs from the current one in
+     * the parts up to and including part n, skipping the countAfter(n)
+     * partitions which do not.  Returns false when there is none.
+     */
+    bool skip (size_t n)
+    {
+        return incr (static_cast<int>(n));
+    }
+
+    /**
+     * the number of partitions in the enumeration
+     */
+    uint64_t count () const
+    {
+        uint64_t ret = 1;
+        for (size_t i=0; i<_pcombos.size(); i++)
+            ret *= _pcombos[i].count();
+        return ret;
+    }
+
+    /**
+     * the number of partitions which agree with any one partition in
+     * the parts up to and including part n
+     */
+    uint64_t countAfter (size_t n) const
+    {
+        uint64_t ret = 1;
+        for (size_t i=n+1; i<_pcombos.size(); i++)
+            ret *= _pcombos[i].count();
+        return ret;
+    }
+
+    /**
+     * jump to the partition with the given rank
+     */
+    void seek (uint64_t rank)
+    {
+        std::vector<uint64_t> digits(numParts());
+        for (int i=static_cast<int>(numParts())-1; i>=0; i--)
+        {
+            uint64_t radix = _pcombos[i].count();
+            digits[i] = rank % radix;
+            rank /= radix;
+        }
+        for (size_t i=0; i<numParts(); i++)
+        {
+            setup (static_cast<int>(i));
+            _pcombos[i].seek (digits[i]);
+            makeMask (i);
+        }
+    }
+
 private:
     size_t _setSize;
     std::vector<size_t> _parts;
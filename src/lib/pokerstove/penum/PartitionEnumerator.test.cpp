@@ -25,6 +25,34 @@ TEST(PartitionEnumerator, chinese_settings) {
     EXPECT_EQ(72072, visits);
 }
 
+TEST(PartitionEnumerator, seek_matches_next) {
+    std::vector<size_t> partitions;
+    partitions.push_back(2);
+    partitions.push_back(0);
+    partitions.push_back(3);
+    partitions.push_back(1);
+
+    PartitionEnumerator2 walker(9, partitions);
+    EXPECT_EQ(36*1*35*4, walker.count());
+    uint64_t rank = 0;
+    do {
+        PartitionEnumerator2 jump(9, partitions);
+        jump.seek(rank++);
+        ASSERT_EQ(walker.str(), jump.str());
+        for (size_t p=0; p<partitions.size(); p++)
+            EXPECT_EQ(walker.getMask(p), jump.getMask(p));
+
+        // the enumeration carries on from the seek position
+        if (jump.next()) {
+            PartitionEnumerator2 after(9, partitions);
+            after.seek(rank);
+            EXPECT_EQ(after.str(), jump.str());
+        }
+    }
+    while (walker.next());
+    EXPECT_EQ(walker.count(), rank);
+}
+
 TEST(PartitionEnumerator, DISABLED_slow_all_ofcp_draws) {
     // ofcp = open face chinese poker
     // compute the number of possible draw sets in open face chinese poker
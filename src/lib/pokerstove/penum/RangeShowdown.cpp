@@ -0,0 +1,530 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#include "RangeShowdown.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#include <pokerstove/util/combinations.h>
+#include <pokerstove/util/lastbit.h>
+#include <pokerstove/util/utypes.h>
+
+using std::vector;
+
+namespace pokerstove {
+
+namespace {
+
+const int NUM_CARDS = 52;
+
+struct RangeHand
+{
+    PokerEvaluation eval;
+    uint64_t mask;
+    double weight;
+
+    bool operator<(const RangeHand& other) const
+    {
+        return eval < other.eval;
+    }
+};
+
+/**
+ * Weight sums of a set of hands, from which the weight of the hands
+ * which share no card with a given hand follows by inclusion-exclusion:
+ * the total, less the hands through each of its cards, plus those
+ * through each pair of its cards, and so on.  Singles are kept per card,
+ * larger sets of cards in a table.
+ */
+class BlockerSums
+{
+public:
+    BlockerSums()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        _total = 0.0;
+        std::fill(_card, _card+NUM_CARDS, 0.0);
+        _sets.clear();
+    }
+
+    void add(uint64_t hand, double weight)
+    {
+        _total += weight;
+        for (uint64_t sub=hand; sub; sub=(sub-1) & hand)
+        {
+            if ((sub & (sub-1)) == 0)
+                _card[lastbit(sub)] += weight;
+            else
+                _sets[sub] += weight;
+        }
+    }
+
+    /**
+     * the weight of the hands disjoint from hand
+     */
+    double compatible(uint64_t hand) const
+    {
+        double blocked = 0.0;
+        for (uint64_t sub=hand; sub; sub=(sub-1) & hand)
+        {
+            double sum;
+            if ((sub & (sub-1)) == 0)
+                sum = _card[lastbit(sub)];
+            else
+            {
+                std::unordered_map<uint64_t, double>::const_iterator it = _sets.find(sub);
+                if (it == _sets.end())
+                    continue;
+                sum = it->second;
+            }
+            if (countbits(sub) % 2 == 1)
+                blocked += sum;
+            else
+                blocked -= sum;
+        }
+        return _total - blocked;
+    }
+
+private:
+    double _total;
+    double _card[NUM_CARDS];
+    std::unordered_map<uint64_t, double> _sets;
+};
+
+/**
+ * The hands of a range which miss the board, evaluated on it and sorted
+ * weakest first.
+ */
+void evaluateRange(const CardDistribution& range,
+                   const CardSet& board,
+                   const PokerHandEvaluator& peval,
+                   vector<RangeHand>& hands)
+{
+    hands.clear();
+    for (size_t i=0; i<range.size(); i++)
+    {
+        const CardSet& cards = range[i];
+        if (cards.intersects(board))
+            continue;
+        RangeHand hand;
+        hand.eval   = peval.evaluateHand(cards, board).high();
+        hand.mask   = cards.mask();
+        hand.weight = range[cards];
+        hands.push_back(hand);
+    }
+    std::sort(hands.begin(), hands.end());
+}
+
+/**
+ * Add the showdowns of every hand in hands0 against hands1 on one board
+ * to the results.  The hands of hands0 are taken a level of strength at
+ * a time, while hands1 is swept once from the bottom.
+ */
+void showdown(const vector<RangeHand>& hands0,
+              const vector<RangeHand>& hands1,
+              vector<EquityResult>& results)
+{
+    BlockerSums every;
+    for (size_t j=0; j<hands1.size(); j++)
+        every.add(hands1[j].mask, hands1[j].weight);
+
+    BlockerSums below;
+    BlockerSums level;
+    size_t j = 0;
+    size_t i = 0;
+    while (i < hands0.size())
+    {
+        const PokerEvaluation eval = hands0[i].eval;
+        for (; j<hands1.size() && hands1[j].eval < eval; j++)
+            below.add(hands1[j].mask, hands1[j].weight);
+        level.clear();
+        for (size_t k=j; k<hands1.size() && hands1[k].eval == eval; k++)
+            level.add(hands1[k].mask, hands1[k].weight);
+
+        for (; i<hands0.size() && hands0[i].eval == eval; i++)
+        {
+            const uint64_t mask = hands0[i].mask;
+            const double weight = hands0[i].weight;
+            const double lose = below.compatible(mask);
+            const double tie = level.compatible(mask);
+            const double win = every.compatible(mask) - lose - tie;
+            results[0].winShares += weight*lose;
+            results[1].winShares += weight*win;
+            results[0].tieShares += 0.5*weight*tie;
+            results[1].tieShares += 0.5*weight*tie;
+        }
+    }
+}
+
+/**
+ * Throws std::invalid_argument unless the evaluator has a single pot and
+ * every hand is complete.
+ */
+void checkRanges(const vector<CardDistribution>& ranges,
+                 const CardSet& board,
+                 const PokerHandEvaluator& peval)
+{
+    if (peval.evaluationSize() != 1)
+        throw std::invalid_argument("rangeShowdown: split pot games are not supported");
+    for (size_t r=0; r<ranges.size(); r++)
+        for (size_t i=0; i<ranges[r].size(); i++)
+            if (ranges[r][i].size() != peval.handSize())
+                throw std::invalid_argument("rangeShowdown: incomplete hand "
+                                            + ranges[r][i].str());
+    if (board.size() > peval.boardSize())
+        throw std::invalid_argument("rangeShowdown: too many board cards " + board.str());
+}
+
+/**
+ * Call visit(fullBoard) for every way to deal out the rest of the board.
+ */
+template <class Visitor>
+void forEachBoard(const CardSet& board, const PokerHandEvaluator& peval, Visitor visit)
+{
+    vector<uint64_t> deck;
+    for (int c=0; c<NUM_CARDS; c++)
+    {
+        const uint64_t card = UINT64_C(1) << c;
+        if (!(board.mask() & card))
+            deck.push_back(card);
+    }
+
+    combinations runouts(deck.size(), peval.boardSize() - board.size());
+    do
+    {
+        uint64_t runout = board.mask();
+        for (size_t k=0; k<runouts.size(); k++)
+            runout |= deck[runouts[k]];
+        visit(CardSet(runout));
+    }
+    while (runouts.next());
+}
+
+/**
+ * The hands of the widest range on one board, as running sums over its
+ * levels of strength: the weight of the hands below level t, in total
+ * and through each card.  With the hands made of two given cards, these
+ * give the weight below any level of the hands which miss a set of
+ * cards.
+ */
+class SortedRange
+{
+public:
+    SortedRange()
+        : _pair(NUM_CARDS*NUM_CARDS, -1)
+    {}
+
+    void build(const vector<RangeHand>& hands)
+    {
+        for (size_t i=0; i<_hands.size(); i++)
+            setPair(_hands[i].mask, -1);
+        _hands = hands;
+        _levels.clear();
+        _levelOf.resize(_hands.size());
+        _sums.assign(NUM_CARDS+1, 0.0);
+        for (size_t i=0; i<_hands.size(); i++)
+        {
+            if (_levels.empty() || _levels.back() < _hands[i].eval)
+            {
+                _levels.push_back(_hands[i].eval);
+                // each level starts from the sums of the one below
+                const size_t last = _sums.size();
+                _sums.resize(last+NUM_CARDS+1);
+                std::copy(_sums.begin()+(last-(NUM_CARDS+1)), _sums.begin()+last, _sums.begin()+last);
+            }
+            double* row = &_sums[_levels.size()*(NUM_CARDS+1)];
+            row[NUM_CARDS] += _hands[i].weight;
+            for (uint64_t m=_hands[i].mask; m; m &= m-1)
+                row[lastbit(m)] += _hands[i].weight;
+            _levelOf[i] = _levels.size()-1;
+            setPair(_hands[i].mask, static_cast<int>(i));
+        }
+    }
+
+    size_t levels() const
+    {
+        return _levels.size();
+    }
+
+    /**
+     * the number of levels below eval
+     */
+    size_t levelsBelow(const PokerEvaluation& eval) const
+    {
+        return std::lower_bound(_levels.begin(), _levels.end(), eval) - _levels.begin();
+    }
+
+    bool isLevel(size_t t, const PokerEvaluation& eval) const
+    {
+        return t < _levels.size() && _levels[t] == eval;
+    }
+
+    /**
+     * The weight of the hands below level t which miss all of cards, and
+     * the cards must all differ.
+     */
+    double compatible(size_t t, const int* cards, size_t ncards) const
+    {
+        const double* row = &_sums[t*(NUM_CARDS+1)];
+        double weight = row[NUM_CARDS];
+        for (size_t i=0; i<ncards; i++)
+            weight -= row[cards[i]];
+        for (size_t i=0; i<ncards; i++)
+            for (size_t j=i+1; j<ncards; j++)
+            {
+                int h = _pair[cards[i]*NUM_CARDS + cards[j]];
+                if (h >= 0 && _levelOf[h] < t)
+                    weight += _hands[h].weight;
+            }
+        return weight;
+    }
+
+private:
+    void setPair(uint64_t mask, int hand)
+    {
+        if (countbits(mask) != 2)
+            return;
+        const int lo = lastbit(mask);
+        const int hi = lastbit(mask & (mask-1));
+        _pair[lo*NUM_CARDS + hi] = hand;
+        _pair[hi*NUM_CARDS + lo] = hand;
+    }
+
+    vector<RangeHand> _hands;
+    vector<PokerEvaluation> _levels;
+    vector<size_t> _levelOf;
+    vector<double> _sums;           // (levels+1) rows of NUM_CARDS+1 running sums
+    vector<int> _pair;              // hand made of two cards, both orders
+};
+
+/**
+ * Walks the tuples of every range but the widest on one board, and
+ * settles each tuple against all of the widest range at once.
+ */
+class MultiwayShowdown
+{
+public:
+    MultiwayShowdown(const vector<vector<RangeHand>>& hands,
+                     const vector<size_t>& players,
+                     size_t last,
+                     const SortedRange& lastRange,
+                     vector<EquityResult>& results)
+        : _hands(hands)
+        , _players(players)
+        , _last(last)
+        , _lastRange(lastRange)
+        , _results(results)
+    {}
+
+    void run()
+    {
+        walk(0, 0, 1.0);
+    }
+
+private:
+    void walk(size_t depth, uint64_t used, double weight)
+    {
+        if (depth == _players.size())
+        {
+            settle(weight);
+            return;
+        }
+        const vector<RangeHand>& hands = _hands[_players[depth]];
+        for (size_t i=0; i<hands.size(); i++)
+        {
+            const RangeHand& hand = hands[i];
+            if (hand.mask & used)
+                continue;
+            size_t ncards = _ncards;
+            for (uint64_t m=hand.mask; m; m &= m-1)
+                _cards[_ncards++] = lastbit(m);
+            _tuple[depth] = &hand;
+            walk(depth+1, used | hand.mask, weight*hand.weight);
+            _ncards = ncards;
+        }
+    }
+
+    /**
+     * Split the pot between the best hands of the tuple and the hands of
+     * the widest range, in the three cases where the widest range is
+     * below, level with, or above the best of the tuple.
+     */
+    void settle(double weight)
+    {
+        // the players level with the best hand of the tuple
+        const PokerEvaluation top = bestEval();
+        size_t nbest = 0;
+        for (size_t d=0; d<_players.size(); d++)
+            if (_tuple[d]->eval == top)
+                _best[nbest++] = _players[d];
+
+        const size_t t = _lastRange.levelsBelow(top);
+        const double below = _lastRange.compatible(t, _cards, _ncards);
+        const double upto = _lastRange.isLevel(t, top)
+                            ? _lastRange.compatible(t+1, _cards, _ncards) : below;
+        const double all = _lastRange.compatible(_lastRange.levels(), _cards, _ncards);
+
+        if (nbest == 1)
+            _results[_best[0]].winShares += weight*below;
+        else
+            for (size_t b=0; b<nbest; b++)
+                _results[_best[b]].tieShares += weight*below/nbest;
+        for (size_t b=0; b<nbest; b++)
+            _results[_best[b]].tieShares += weight*(upto-below)/(nbest+1);
+        _results[_last].tieShares += weight*(upto-below)/(nbest+1);
+        _results[_last].winShares += weight*(all-upto);
+    }
+
+    PokerEvaluation bestEval() const
+    {
+        PokerEvaluation top = _tuple[0]->eval;
+        for (size_t d=1; d<_players.size(); d++)
+            if (top < _tuple[d]->eval)
+                top = _tuple[d]->eval;
+        return top;
+    }
+
+    const vector<vector<RangeHand>>& _hands;
+    const vector<size_t>& _players;
+    size_t _last;
+    const SortedRange& _lastRange;
+    vector<EquityResult>& _results;
+
+    const RangeHand* _tuple[EXACT_SHARES_MAX_HANDS];
+    size_t _best[EXACT_SHARES_MAX_HANDS];
+    int _cards[NUM_CARDS];
+    size_t _ncards = 0;
+};
+
+}
+
+vector<EquityResult> rangeShowdown(const CardDistribution& range0,
+                                   const CardDistribution& range1,
+                                   const CardSet& board,
+                                   const PokerHandEvaluator& peval)
+{
+    vector<CardDistribution> ranges = {range0, range1};
+    checkRanges(ranges, board, peval);
+
+    vector<EquityResult> results(2);
+    vector<RangeHand> hands0;
+    vector<RangeHand> hands1;
+    forEachBoard(board, peval, [&] (const CardSet& fullBoard)
+    {
+        evaluateRange(range0, fullBoard, peval, hands0);
+        evaluateRange(range1, fullBoard, peval, hands1);
+        showdown(hands0, hands1, results);
+    });
+    return results;
+}
+
+vector<EquityResult> rangeShowdown(const vector<CardDistribution>& ranges,
+                                   const CardSet& board,
+                                   const PokerHandEvaluator& peval)
+{
+    if (ranges.size() == 2)
+        return rangeShowdown(ranges[0], ranges[1], board, peval);
+    if (ranges.size() < 2 || ranges.size() > EXACT_SHARES_MAX_HANDS)
+        throw std::invalid_argument("rangeShowdown: need two to ten ranges");
+    if (peval.handSize() > 2)
+        throw std::invalid_argument("rangeShowdown: more than two ranges need hands of two cards or fewer");
+    checkRanges(ranges, board, peval);
+
+    // the widest range is the one settled by running sums
+    size_t last = 0;
+    for (size_t r=1; r<ranges.size(); r++)
+        if (ranges[r].size() > ranges[last].size())
+            last = r;
+    vector<size_t> players;
+    for (size_t r=0; r<ranges.size(); r++)
+        if (r != last)
+            players.push_back(r);
+
+    vector<EquityResult> results(ranges.size());
+    vector<vector<RangeHand>> hands(ranges.size());
+    SortedRange lastRange;
+    forEachBoard(board, peval, [&] (const CardSet& fullBoard)
+    {
+        for (size_t r=0; r<ranges.size(); r++)
+            evaluateRange(ranges[r], fullBoard, peval, hands[r]);
+        lastRange.build(hands[last]);
+        MultiwayShowdown(hands, players, last, lastRange, results).run();
+    });
+    return results;
+}
+
+EquityMatrix rangeMatrix(const CardDistribution& range0,
+                         const CardDistribution& range1,
+                         const CardSet& board,
+                         const PokerHandEvaluator& peval)
+{
+    vector<CardDistribution> ranges = {range0, range1};
+    checkRanges(ranges, board, peval);
+
+    vector<CardSet> hands0(range0.size());
+    vector<CardSet> hands1(range1.size());
+    for (size_t i=0; i<hands0.size(); i++)
+        hands0[i] = range0[i];
+    for (size_t j=0; j<hands1.size(); j++)
+        hands1[j] = range1[j];
+    EquityMatrix matrix(hands0, hands1);
+    matrix.game = peval.str();
+    matrix.board = board.str();
+
+    // each hand is evaluated once per board, and every pair which misses
+    // the board and shares no card is settled from the two evaluations
+    vector<PokerEvaluation> evals0(hands0.size());
+    vector<PokerEvaluation> evals1(hands1.size());
+    auto settle = [&] (size_t i, size_t j, EquityMatrix::Counts& counts)
+    {
+        if (evals1[j] < evals0[i])
+            counts.win++;
+        else if (evals0[i] < evals1[j])
+            counts.lose++;
+        else
+            counts.tie++;
+    };
+    forEachBoard(board, peval, [&] (const CardSet& fullBoard)
+    {
+        for (size_t i=0; i<hands0.size(); i++)
+            if (!hands0[i].intersects(fullBoard))
+                evals0[i] = peval.evaluateHand(hands0[i], fullBoard).high();
+        for (size_t j=0; j<hands1.size(); j++)
+            if (!hands1[j].intersects(fullBoard))
+                evals1[j] = peval.evaluateHand(hands1[j], fullBoard).high();
+
+        const uint64_t dead = fullBoard.mask();
+        if (matrix.dense())
+        {
+            size_t k = 0;
+            for (size_t i=0; i<hands0.size(); i++, k+=hands1.size())
+            {
+                if (hands0[i].mask() & dead)
+                    continue;
+                // pairs which share a card are dead too
+                const uint64_t rowDead = dead | hands0[i].mask();
+                for (size_t j=0; j<hands1.size(); j++)
+                    if (!(hands1[j].mask() & rowDead))
+                        settle(i, j, matrix[k+j]);
+            }
+        }
+        else
+        {
+            for (size_t k=0; k<matrix.entries(); k++)
+            {
+                const size_t i = matrix.row(k);
+                const size_t j = matrix.col(k);
+                if (!((hands0[i].mask() | hands1[j].mask()) & dead))
+                    settle(i, j, matrix[k]);
+            }
+        }
+    });
+    return matrix;
+}
+
+}
@@ -0,0 +1,63 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PENUM_RANGESHOWDOWN_H_
+#define PENUM_RANGESHOWDOWN_H_
+
+#include <vector>
+#include <pokerstove/peval/PokerHandEvaluator.h>
+#include "CardDistribution.h"
+#include "EquityMatrix.h"
+
+namespace pokerstove
+{
+/**
+ * Equity of one range of complete hands against another, the same as
+ * ShowdownEnumerator::calculateEquity gives for the two distributions.
+ *
+ * Rather than pairing every hand with every opposing hand, each board
+ * evaluates the hands of both ranges once and sorts them by strength.
+ * The weight of the opposing hands below, level with, and above a hand
+ * comes from running sums over the sorted order.  The opposing hands
+ * which share a card with it are taken back out by inclusion-exclusion
+ * over sums kept per card and per set of cards.  Boards with cards to
+ * come are dealt out one runout at a time.
+ *
+ * The evaluator must have a single evaluation per hand, not a split
+ * pot, and every hand must be complete, or std::invalid_argument is
+ * thrown.
+ */
+std::vector<EquityResult> rangeShowdown(const CardDistribution& range0,
+                                        const CardDistribution& range1,
+                                        const CardSet& board,
+                                        const PokerHandEvaluator& peval);
+
+/**
+ * Equity of any number of ranges of complete hands, as for two ranges.
+ * The widest range is not paired with the others: on each board its
+ * weight below, level with, and above the best of the other hands comes
+ * from running sums over its sorted hands, less those which share a card
+ * with the other hands.  The tuples of the other ranges are walked one
+ * hand at a time, each hand evaluated once per board.  With more than
+ * two ranges the hands may have at most two cards, where taking out the
+ * hands through each card and adding back the hands made of two of them
+ * is exact.
+ */
+std::vector<EquityResult> rangeShowdown(const std::vector<CardDistribution>& ranges,
+                                        const CardSet& board,
+                                        const PokerHandEvaluator& peval);
+
+/**
+ * The showdown counts of every hand of range0 against every hand of
+ * range1, for any later weighting of the two ranges, see EquityMatrix.
+ * Each hand is evaluated once per board, and each pair settled by
+ * comparing the evaluations.  The same restrictions on the evaluator and
+ * the hands as for rangeShowdown apply.
+ */
+EquityMatrix rangeMatrix(const CardDistribution& range0,
+                         const CardDistribution& range1,
+                         const CardSet& board,
+                         const PokerHandEvaluator& peval);
+}
+
+#endif  // PENUM_RANGESHOWDOWN_H_
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "RangeShowdown.h"
+#include "ShowdownEnumerator.h"
+
+using namespace pokerstove;
+using namespace std;
+
+namespace {
+
+/**
+ * calculateEquity hands wide ranges to rangeShowdown itself, exact
+ * shares keep it on the tuple by tuple enumeration
+ */
+vector<EquityResult> tupleEquity(const vector<CardDistribution>& dists,
+                                 const CardSet& board,
+                                 boost::shared_ptr<PokerHandEvaluator> peval)
+{
+    ShowdownEnumerator showdown;
+    showdown.useExactShares(true);
+    return showdown.calculateEquity(dists, board, peval);
+}
+
+void expectMatchesEnumerator(const string& game,
+                             const string& hands0,
+                             const string& hands1,
+                             const string& board)
+{
+    vector<CardDistribution> dists(2);
+    dists[0].parse(hands0);
+    dists[1].parse(hands1);
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc(game);
+    vector<EquityResult> expected = tupleEquity(dists, CardSet(board), peval);
+    vector<EquityResult> actual = rangeShowdown(dists[0], dists[1], CardSet(board), *peval);
+    ASSERT_EQ(2, actual.size());
+    for (size_t i=0; i<2; i++)
+    {
+        EXPECT_NEAR(expected[i].winShares, actual[i].winShares, 1e-9*expected[i].winShares)
+            << hands0 << " vs " << hands1 << " on " << board;
+        EXPECT_NEAR(expected[i].tieShares, actual[i].tieShares, 1e-9*expected[i].tieShares)
+            << hands0 << " vs " << hands1 << " on " << board;
+    }
+}
+
+void expectMatchesEnumerator(const string& game,
+                             const vector<string>& hands,
+                             const string& board)
+{
+    vector<CardDistribution> dists(hands.size());
+    for (size_t i=0; i<hands.size(); i++)
+        dists[i].parse(hands[i]);
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc(game);
+    vector<EquityResult> expected = tupleEquity(dists, CardSet(board), peval);
+    vector<EquityResult> actual = rangeShowdown(dists, CardSet(board), *peval);
+    ASSERT_EQ(hands.size(), actual.size());
+    for (size_t i=0; i<hands.size(); i++)
+    {
+        EXPECT_NEAR(expected[i].winShares, actual[i].winShares, 1e-9*expected[i].winShares)
+            << "player " << i << " on " << board;
+        EXPECT_NEAR(expected[i].tieShares, actual[i].tieShares, 1e-9*expected[i].tieShares)
+            << "player " << i << " on " << board;
+    }
+}
+
+}
+
+TEST(RangeShowdown, River)
+{
+    // hands which share cards with each other, and with the board
+    expectMatchesEnumerator("h", "AsAh,AcAd,KdKh,AsKs,7c7d", "KsKh,KcKd,AhKh,QsJs,7h7s",
+                            "Ts9s8d2c3h");
+    expectMatchesEnumerator("h", "AsAh,AcAd", "AsAh,AcAd,AdAh", "2c3d4h5s7c");
+}
+
+TEST(RangeShowdown, TurnAndFlop)
+{
+    expectMatchesEnumerator("h", "AsAh,AcAd,KdKh,AsKs", "KsKh,QcQd,AhKh,QsJs", "Ts9s8d2c");
+    expectMatchesEnumerator("h", "AsAh,KdKh,AsKs", "KsKh,AhKh,QsJs", "Ts9s8d");
+}
+
+TEST(RangeShowdown, Weights)
+{
+    CardDistribution range0;
+    CardDistribution range1;
+    range0.parse("AsAh,KdKh");
+    range1.parse("KsKh,QsJs");
+    range0[CardSet("KdKh")] = 3.0;
+    vector<CardDistribution> dists = {range0, range1};
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    CardSet board("Ts9s8d2c3h");
+    vector<EquityResult> expected = tupleEquity(dists, board, peval);
+    vector<EquityResult> actual = rangeShowdown(range0, range1, board, *peval);
+    EXPECT_DOUBLE_EQ(expected[0].winShares, actual[0].winShares);
+    EXPECT_DOUBLE_EQ(expected[1].winShares, actual[1].winShares);
+    EXPECT_DOUBLE_EQ(expected[0].tieShares, actual[0].tieShares);
+}
+
+TEST(RangeShowdown, Omaha)
+{
+    // four card hands need the sums over sets of two and three cards
+    expectMatchesEnumerator("O", "AsAhKsKh,AcAd2c3d,KdKcQdQc", "AsKs2s3s,QhJhTh9h,AcKd2c3d",
+                            "Ts9s8d2h3h");
+}
+
+TEST(RangeShowdown, Multiway)
+{
+    // the widest range shares cards with every other, and ties three ways
+    expectMatchesEnumerator("h", {"AsAh,KdKh,QcQd", "AsKs,AhKh,7c7d", "KsKh,AcAd,AdKd,QsJs,2c3c,8h8s"},
+                            "Ts9s8d2h4d");
+    expectMatchesEnumerator("h", {"AcKc,AdKd", "AhKh,AsKs", "AcKd,AhKs,AdKc,QcQd"}, "2c3d4h5s9c");
+    expectMatchesEnumerator("h", {"AsAh,KdKh", "QsJs,7c7d", "AcKc,9s9h,JdTd", "AdQd,KsKc,8c8h,5d4d"},
+                            "Ts9d8d2c");
+    expectMatchesEnumerator("h", {"AsAh,KdKh", "QsJs,7c7d", "AcKc,9s9h", "AdQd,KsKc,8c8h"}, "Ts9d8d");
+}
+
+TEST(RangeShowdown, MultiwayWeights)
+{
+    vector<CardDistribution> dists(3);
+    dists[0].parse("AsAh,KdKh");
+    dists[1].parse("QsJs,AcKc");
+    dists[2].parse("KsKh,QcQd,7h6h");
+    dists[0][CardSet("KdKh")] = 2.0;
+    dists[2][CardSet("QcQd")] = 3.0;
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    CardSet board("Ts9s8d2c3h");
+    vector<EquityResult> expected = tupleEquity(dists, board, peval);
+    vector<EquityResult> actual = rangeShowdown(dists, board, *peval);
+    for (size_t i=0; i<3; i++)
+    {
+        EXPECT_DOUBLE_EQ(expected[i].winShares, actual[i].winShares);
+        EXPECT_DOUBLE_EQ(expected[i].tieShares, actual[i].tieShares);
+    }
+}
+
+TEST(RangeShowdown, RejectsSplitPotsAndPartialHands)
+{
+    CardDistribution range0;
+    CardDistribution range1;
+    range0.parse("AsAh");
+    range1.parse("Ks");
+    CardSet board("Ts9s8d2c3h");
+    EXPECT_THROW(rangeShowdown(range0, range1, board, *PokerHandEvaluator::alloc("h")),
+                 std::invalid_argument);
+    range1.parse("KsKh");
+    EXPECT_THROW(rangeShowdown(range0, range1, board, *PokerHandEvaluator::alloc("o")),
+                 std::invalid_argument);
+
+    // more than two ranges of four card hands
+    vector<CardDistribution> omaha(3);
+    omaha[0].parse("AsAhKsKh");
+    omaha[1].parse("QsQhJsJh");
+    omaha[2].parse("AcAdKcKd");
+    EXPECT_THROW(rangeShowdown(omaha, board, *PokerHandEvaluator::alloc("O")),
+                 std::invalid_argument);
+}
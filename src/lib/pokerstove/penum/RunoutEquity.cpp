@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#include "RunoutEquity.h"
+
+#include <stdexcept>
+#include <pokerstove/util/lastbit.h>
+
+using std::vector;
+
+namespace pokerstove {
+
+namespace {
+
+// single cards are indexed by their code, pairs after them by both codes
+const size_t NUM_CARDS = STANDARD_DECK_SIZE;
+const size_t PAIR_BASE = NUM_CARDS;
+
+}
+
+RunoutEquity::RunoutEquity ()
+    : results ()
+    , _depth (0)
+    , _byCards ()
+{
+}
+
+RunoutEquity::RunoutEquity (size_t nplayers, size_t depth)
+    : results (nplayers, EquityResult())
+    , _depth (depth)
+    , _byCards ()
+{
+    if (depth < 1 || depth > 2)
+        throw std::invalid_argument ("RunoutEquity, depth must be one or two");
+    const size_t slots = (depth == 1) ? NUM_CARDS : PAIR_BASE + NUM_CARDS*NUM_CARDS;
+    _byCards.assign (slots, vector<EquityResult> (nplayers, EquityResult()));
+}
+
+size_t RunoutEquity::index (const CardSet& cards) const
+{
+    uint64_t mask = cards.mask();
+    const size_t ncards = cards.size();
+    if (ncards < 1 || ncards > _depth)
+        throw std::invalid_argument ("RunoutEquity, no results for " + cards.str());
+    const size_t low = lastbit (mask);
+    if (ncards == 1)
+        return low;
+    mask &= mask-1;
+    return PAIR_BASE + low*NUM_CARDS + lastbit (mask);
+}
+
+const vector<EquityResult>& RunoutEquity::operator[] (const CardSet& cards) const
+{
+    return _byCards[index (cards)];
+}
+
+void RunoutEquity::add (const CardSet& dealt, const vector<EquityResult>& runout)
+{
+    const size_t n = runout.size();
+    for (uint64_t first=dealt.mask(); first; first &= first-1)
+    {
+        const size_t low = lastbit (first);
+        vector<EquityResult>& single = _byCards[low];
+        for (size_t i=0; i<n; i++)
+            single[i] += runout[i];
+        if (_depth < 2)
+            continue;
+        for (uint64_t second=first & (first-1); second; second &= second-1)
+        {
+            vector<EquityResult>& pair = _byCards[PAIR_BASE + low*NUM_CARDS + lastbit (second)];
+            for (size_t i=0; i<n; i++)
+                pair[i] += runout[i];
+        }
+    }
+}
+
+void RunoutEquity::setExactShares ()
+{
+    for (size_t i=0; i<results.size(); i++)
+        results[i].setExactShares ();
+    for (size_t k=0; k<_byCards.size(); k++)
+        for (size_t i=0; i<_byCards[k].size(); i++)
+            _byCards[k][i].setExactShares ();
+}
+
+}
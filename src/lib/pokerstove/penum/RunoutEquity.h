@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PENUM_RUNOUTEQUITY_H_
+#define PENUM_RUNOUTEQUITY_H_
+
+#include <vector>
+#include <pokerstove/peval/PokerHandEvaluator.h>
+
+namespace pokerstove
+{
+/**
+ * The results of a query broken down by the cards dealt to the board.
+ * Every runout is added to the results of each card it deals to the
+ * board, and with a depth of two also to those of each pair of cards it
+ * deals.  On a flop the results of a card are the turn equity for that
+ * turn card, and the results of a pair the river equity for that turn
+ * and river, the same as calculateEquity gives on those boards.
+ */
+class RunoutEquity
+{
+public:
+    RunoutEquity ();
+    RunoutEquity (size_t nplayers, size_t depth);
+
+    size_t depth () const          { return _depth; }
+
+    /**
+     * The results of the runouts which deal all of cards to the board,
+     * one card, or two within the depth.  Throws std::invalid_argument for
+     * other sizes.
+     */
+    const std::vector<EquityResult>& operator[] (const CardSet& cards) const;
+
+    /**
+     * add the results of one runout which deals the cards dealt to the
+     * board
+     */
+    void add (const CardSet& dealt, const std::vector<EquityResult>& runout);
+
+    /**
+     * set the shares from the exact counts, see EquityResult::setExactShares
+     */
+    void setExactShares ();
+
+    std::vector<EquityResult> results;   //!< the whole query
+
+private:
+    size_t index (const CardSet& cards) const;
+
+    size_t _depth;
+    std::vector<std::vector<EquityResult> > _byCards;
+};
+}
+
+#endif  // PENUM_RUNOUTEQUITY_H_
@@ -3,11 +3,27 @@
  */
 #include "ShowdownEnumerator.h"
 
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <cmath>
+#include <random>
 #include <string>
+#include <typeinfo>
 #include <vector>
+#include <boost/lexical_cast.hpp>
+#include <pokerstove/util/combinations.h>
+#include <pokerstove/util/utypes.h>
 
+#include <pokerstove/peval/HoldemHandEvaluator.h>
+#include <pokerstove/peval/OmahaPrepared.h>
+#include <pokerstove/peval/Rank.h>
+#include <pokerstove/peval/Suit.h>
+
+#include "HoldemHeadsUp.h"
 #include "Odometer.h"
 #include "PartitionEnumerator.h"
+#include "RangeShowdown.h"
 #include "SimpleDeck.hpp"
 
 using std::string;
@@ -16,20 +32,1391 @@ using std::runtime_error;
 
 namespace pokerstove {
 
+namespace {
+
+// how many runouts to deal between looks at the checkpoint clock
+const size_t CHECKPOINT_STRIDE = 1 << 12;
+
+// rangeShowdown takes boards with cards to come once the tuples of the
+// ranges outnumber the hands and tuples it walks by this much
+const double RANGE_SHOWDOWN_WIDTH = 64.0;
+
+/**
+ * A permutation of the suits, the ith entry is the suit that cards of
+ * suit i are moved to.  This is the argument order of CardSet::rotateSuits.
+ */
+typedef vector<int> SuitPermutation;
+
+CardSet permuteSuits (const CardSet& cards, const SuitPermutation& perm)
+{
+    return cards.rotateSuits (perm[0], perm[1], perm[2], perm[3]);
+}
+
+bool isInvariant (const CardDistribution& dist, const SuitPermutation& perm)
+{
+    for (size_t i=0; i<dist.size(); i++)
+        if (dist[permuteSuits(dist[i], perm)] != dist[dist[i]])
+            return false;
+    return true;
+}
+
+/**
+ * Find all suit permutations which map each distribution, each board
+ * distribution, and the cards common to the boards onto themselves.  The
+ * identity is always the first element.
+ */
+vector<SuitPermutation> findSymmetries (const vector<CardDistribution>& dists,
+                                        const vector<CardDistribution>& boards,
+                                        const CardSet& common)
+{
+    vector<SuitPermutation> ret;
+    SuitPermutation perm (Suit::NUM_SUIT);
+    for (size_t i=0; i<Suit::NUM_SUIT; i++)
+        perm[i] = i;
+    do
+    {
+        bool invariant = (permuteSuits (common, perm) == common);
+        for (size_t b=0; invariant && b<boards.size(); b++)
+            invariant = isInvariant (boards[b], perm);
+        for (size_t i=0; invariant && i<dists.size(); i++)
+            invariant = isInvariant (dists[i], perm);
+        if (invariant)
+            ret.push_back (perm);
+    }
+    while (std::next_permutation (perm.begin(), perm.end()));
+    return ret;
+}
+
+/**
+ * Lexicographically compare the image of the listed slots under the
+ * permutation to the slots themselves.  Negative if the image sorts
+ * first, zero if the slots are fixed by the permutation.
+ */
+int compareImage (const vector<CardSet>& cards,
+                  const vector<size_t>& slots,
+                  const SuitPermutation& perm)
+{
+    for (size_t i=0; i<slots.size(); i++)
+    {
+        const CardSet& cs = cards[slots[i]];
+        CardSet image = permuteSuits (cs, perm);
+        if (image < cs)
+            return -1;
+        if (cs < image)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * Reference counted set of the cards held by the current hand tuple.
+ * Swapping one hand for another only touches the cards of those two
+ * hands, and the live cards of the deck are kept in step.
+ */
+class DeadCards
+{
+public:
+    explicit DeadCards (SimpleDeck& deck)
+        : _deck(deck)
+        , _cards()
+        , _collisions(0)
+    {
+        std::fill (_count, _count+STANDARD_DECK_SIZE, 0);
+    }
+
+    void insert (const CardSet& cards)
+    {
+        uint64_t mask = cards.mask();
+        while (mask)
+        {
+            if (_count[lastbit(mask)]++ > 0)
+                _collisions++;
+            mask &= mask-1;
+        }
+        _cards |= cards;
+        _deck.take (cards);
+    }
+
+    void remove (const CardSet& cards)
+    {
+        uint64_t mask = cards.mask();
+        uint64_t freed = 0;
+        while (mask)
+        {
+            int c = lastbit(mask);
+            if (--_count[c] > 0)
+                _collisions--;
+            else
+                freed |= ONE64 << c;
+            mask &= mask-1;
+        }
+        _cards ^= CardSet(freed);
+        _deck.putBack (CardSet(freed));
+    }
+
+    /**
+     * true if no card is held twice
+     */
+    bool disjoint () const
+    {
+        return _collisions == 0;
+    }
+
+    /**
+     * all of the dead cards
+     */
+    const CardSet& cards () const
+    {
+        return _cards;
+    }
+
+    /**
+     * Put the live cards back in the order of a new deck.  The order of
+     * the deck otherwise depends on the history of inserts and removes.
+     */
+    void sortDeck ()
+    {
+        _deck = SimpleDeck ();
+        _deck.remove (_cards);
+    }
+
+private:
+    SimpleDeck& _deck;
+    CardSet _cards;
+    int _count[STANDARD_DECK_SIZE];
+    int _collisions;
+};
+
+/**
+ * Deals runouts as multisets of ranks, for evaluators which ignore the
+ * suits.  One multiset of ranks per dealt slot stands for every runout
+ * with those ranks in those slots, and its multiplicity is the number of
+ * ways to pick live cards of the ranks, the product of C(live,k) over
+ * the ranks.  The cards actually dealt are the first live cards of each
+ * rank, so the hands stay valid card sets.
+ */
+class RankRunouts
+{
+public:
+    RankRunouts (const SimpleDeck& deck, const vector<size_t>& parts)
+    {
+        std::fill (_live, _live+Rank::NUM_RANK, 0);
+        std::fill (_used, _used+Rank::NUM_RANK, 0);
+        for (size_t i=0; i<deck.size(); i++)
+        {
+            int r = lastbit(deck[i].mask()) % Rank::NUM_RANK;
+            _byRank[r][_live[r]++] = deck[i];
+        }
+        for (size_t p=0; p<parts.size(); p++)
+            if (parts[p] > 0)
+            {
+                _slots.push_back (p);
+                _parts.push_back (parts[p]);
+            }
+    }
+
+    /**
+     * Call visit(multiplicity) for each runout, with the runout dealt
+     * into hands on top of the cards already there.
+     */
+    template <class Visitor>
+    void deal (vector<CardSet>& hands, Visitor visit)
+    {
+        if (_slots.empty())
+            visit (UINT64_C(1));
+        else
+            dealSlot (hands, 0, 0, _parts[0], 1, visit);
+    }
+
+private:
+    template <class Visitor>
+    void dealSlot (vector<CardSet>& hands, size_t s, int r, size_t left,
+                   uint64_t multiplicity, Visitor& visit)
+    {
+        if (left == 0)
+        {
+            if (s+1 == _slots.size())
+                visit (multiplicity);
+            else
+                dealSlot (hands, s+1, 0, _parts[s+1], multiplicity, visit);
+            return;
+        }
+        if (r == Rank::NUM_RANK)
+            return;
+
+        CardSet& hand = hands[_slots[s]];
+        const CardSet held = hand;
+        const size_t avail = _live[r]-_used[r];
+        for (size_t k=0; k<=avail && k<=left; k++)
+        {
+            if (k > 0)
+                hand |= _byRank[r][_used[r]+k-1];
+            _used[r] += k;
+            dealSlot (hands, s, r+1, left-k, multiplicity*choose (avail, k), visit);
+            _used[r] -= k;
+        }
+        hand = held;
+    }
+
+    CardSet _byRank[Rank::NUM_RANK][Suit::NUM_SUIT];
+    size_t _live[Rank::NUM_RANK];
+    size_t _used[Rank::NUM_RANK];
+    vector<size_t> _slots;
+    vector<size_t> _parts;
+};
+
+/**
+ * Whether some hand could end up with flushSize cards of one suit,
+ * counting the board.  The cards of a suit still to come are limited by
+ * the slots dealt to and by the live cards of the suit.
+ */
+bool flushPossible (const vector<CardSet>& partitions,
+                    const vector<size_t>& parts,
+                    size_t ndists,
+                    size_t nboards,
+                    const CardSet& dead,
+                    size_t flushSize)
+{
+    for (uint8_t s=0; s<Suit::NUM_SUIT; s++)
+    {
+        const Suit suit(s);
+        const size_t live = Rank::NUM_RANK - countbits (dead.suitMask (suit));
+        size_t onBoard = 0;
+        size_t toBoard = 0;
+        if (nboards > 0)
+        {
+            onBoard = countbits (partitions[ndists].suitMask (suit));
+            toBoard = parts[ndists];
+        }
+        for (size_t p=0; p<ndists; p++)
+        {
+            size_t held = countbits (partitions[p].suitMask (suit)) + onBoard;
+            if (held + std::min (live, parts[p]+toBoard) >= flushSize)
+                return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Walk the hand tuples in enumeration order, calling visit with the
+ * number of runouts dealt to each one, until visit returns false.  This
+ * is the outer loop of the enumeration without the showdowns.  Tuples
+ * which share a card deal no runouts.
+ */
+template <class Visitor>
+void countRunouts (const vector<CardDistribution>& dists,
+                   const CardSet& board,
+                   size_t handsize,
+                   size_t boardsize,
+                   Visitor visit)
+{
+    const size_t ndists = dists.size();
+    vector<size_t> dsizes;
+    for (size_t i=0; i<ndists; i++)
+        dsizes.push_back (dists[i].size());
+
+    SimpleDeck deck;
+    DeadCards dead (deck);
+    vector<CardSet> hands (ndists);
+    size_t boardDraw = 0;
+    if (boardsize > 0)
+    {
+        boardDraw = boardsize-board.size();
+        dead.insert (board);
+    }
+
+    GrayOdometer o(dsizes);
+    for (size_t i=0; i<ndists; i++)
+    {
+        hands[i] = dists[i][o[i]];
+        dead.insert (hands[i]);
+    }
+    do
+    {
+        uint64_t count = 0;
+        if (dead.disjoint ())
+        {
+            size_t live = deck.size ();
+            count = 1;
+            for (size_t i=0; i<ndists; i++)
+            {
+                size_t draw = handsize-hands[i].size();
+                count *= choose (live, draw);
+                live -= draw;
+            }
+            count *= choose (live, boardDraw);
+        }
+        if (!visit (count))
+            return;
+        if (!o.next ())
+            return;
+        size_t i = o.changed ();
+        dead.remove (hands[i]);
+        hands[i] = dists[i][o[i]];
+        dead.insert (hands[i]);
+    }
+    while (true);
+}
+
+/**
+ * An upper bound on the units an exact enumeration adds up: a pot for
+ * the largest weight product, for every tuple and every way to deal each
+ * slot from the cards left.  The weights of the symmetry orbits and
+ * rank runouts only stand for runouts counted here.
+ */
+double exactUnitsBound (const vector<CardDistribution>& dists,
+                        const vector<CardDistribution>& boards,
+                        const CardSet& common,
+                        size_t handsize,
+                        size_t boardsize)
+{
+    double bound = static_cast<double>(EXACT_SHARES_PER_POT);
+    size_t live = STANDARD_DECK_SIZE - common.size();
+    vector<size_t> boardDraws;
+    for (size_t b=0; boardsize>0 && b<boards.size(); b++)
+    {
+        double heaviest = 0.0;
+        size_t fewest = boardsize-common.size();
+        for (size_t j=0; j<boards[b].size(); j++)
+        {
+            heaviest = std::max (heaviest, boards[b][boards[b][j]]);
+            fewest = std::min (fewest, boards[b][j].size());
+        }
+        bound *= heaviest*static_cast<double>(boards[b].size());
+        boardDraws.push_back (boardsize-common.size()-fewest);
+        live -= fewest;
+    }
+    for (size_t i=0; i<dists.size(); i++)
+    {
+        double heaviest = 0.0;
+        size_t fewest = handsize;
+        for (size_t j=0; j<dists[i].size(); j++)
+        {
+            heaviest = std::max (heaviest, dists[i][dists[i][j]]);
+            fewest = std::min (fewest, dists[i][j].size());
+        }
+        bound *= heaviest*static_cast<double>(dists[i].size());
+        bound *= static_cast<double>(choose (live, handsize-fewest));
+        live -= handsize-fewest;
+    }
+    for (size_t b=0; b<boardDraws.size(); b++)
+    {
+        bound *= static_cast<double>(choose (live, boardDraws[b]));
+        live -= boardDraws[b];
+    }
+
+    // the results of the whole pot add up those of every board
+    if (boardDraws.size() > 1)
+        bound *= static_cast<double>(boardDraws.size());
+    return bound;
+}
+
+/**
+ * Throws unless exact shares can count the query: the weights of the
+ * hands and boards are whole numbers, and the units fit in ExactShares.
+ */
+void checkExactWeights (const vector<CardDistribution>& dists,
+                        const vector<CardDistribution>& boards,
+                        const CardSet& common,
+                        size_t handsize,
+                        size_t boardsize)
+{
+    if (dists.size() > EXACT_SHARES_MAX_HANDS)
+        throw runtime_error("ShowdownEnumerator, too many hands for exact shares");
+    for (size_t i=0; i<dists.size()+boards.size(); i++)
+    {
+        const CardDistribution& dist = (i < dists.size()) ? dists[i] : boards[i-dists.size()];
+        for (size_t j=0; j<dist.size(); j++)
+        {
+            double w = dist[dist[j]];
+            if (w < 0.0 || w != std::floor (w))
+                throw runtime_error("ShowdownEnumerator, exact shares need whole number weights: "
+                                    + dist.str());
+        }
+    }
+    if (exactUnitsBound (dists, boards, common, handsize, boardsize) >= std::ldexp (1.0, 8*sizeof(ExactShares)))
+        throw runtime_error("ShowdownEnumerator, weights too large for exact shares");
+}
+
+/**
+ * Throws unless there is an evaluator and every player has at least one
+ * hand, an empty distribution would give a query with no runouts.
+ */
+void checkQuery (const vector<CardDistribution>& dists, const PokerHandEvaluator* peval)
+{
+    if (peval == NULL)
+        throw runtime_error("ShowdownEnumerator, null evaluator");
+    if (dists.size() < 2)
+        throw runtime_error("ShowdownEnumerator, need at least two hands");
+    for (size_t i=0; i<dists.size(); i++)
+        if (dists[i].size() == 0)
+            throw runtime_error("ShowdownEnumerator, no hands for player "
+                                + boost::lexical_cast<string>(i));
+}
+
+/**
+ * Throws unless there is at least one board, and none has more cards
+ * than the game deals to the board.
+ */
+void checkBoards (const CardDistribution& boards, const PokerHandEvaluator& peval)
+{
+    if (boards.size() == 0)
+        throw runtime_error("ShowdownEnumerator, no boards");
+    for (size_t i=0; i<boards.size(); i++)
+        if (boards[i].size() > peval.boardSize())
+            throw runtime_error("ShowdownEnumerator, board too large: " + boards[i].str());
+}
+
+/**
+ * true if the two distributions hold the same hands with the same weights
+ */
+bool sameDistribution (const CardDistribution& a, const CardDistribution& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i=0; i<a.size(); i++)
+        if (a[i] != b[i] || a[a[i]] != b[b[i]])
+            return false;
+    return true;
+}
+
+/**
+ * The players with identical distributions, in groups of two or more.
+ * The players of a group can trade places without changing the query.
+ */
+vector<vector<size_t> > identicalPlayers (const vector<CardDistribution>& dists)
+{
+    vector<vector<size_t> > groups;
+    vector<bool> grouped (dists.size(), false);
+    for (size_t i=0; i<dists.size(); i++)
+    {
+        if (grouped[i])
+            continue;
+        vector<size_t> group (1, i);
+        for (size_t j=i+1; j<dists.size(); j++)
+            if (!grouped[j] && sameDistribution (dists[i], dists[j]))
+            {
+                grouped[j] = true;
+                group.push_back (j);
+            }
+        if (group.size() > 1)
+            groups.push_back (group);
+    }
+    return groups;
+}
+
+/**
+ * true if the cards of the players in the group strictly increase
+ */
+bool inOrder (const vector<CardSet>& cards, const vector<size_t>& group)
+{
+    for (size_t i=1; i<group.size(); i++)
+        if (!(cards[group[i-1]] < cards[group[i]]))
+            return false;
+    return true;
+}
+
+uint64_t factorial (size_t n)
+{
+    uint64_t ret = 1;
+    for (size_t i=2; i<=n; i++)
+        ret *= i;
+    return ret;
+}
+
+/**
+ * Adds each showdown to the results of the cards it deals to the board.
+ */
+class BreakdownVisitor : public ShowdownVisitor
+{
+public:
+    BreakdownVisitor (RunoutEquity& breakdown, const CardSet& board)
+        : _breakdown (breakdown)
+        , _board (board)
+    {}
+
+    virtual void visit (const vector<CardSet>&,
+                        const CardSet& board,
+                        double,
+                        ExactShares,
+                        const vector<PokerHandEvaluation>&,
+                        const vector<EquityResult>& shares)
+    {
+        _breakdown.add (CardSet (board.mask() & ~_board.mask()), shares);
+    }
+
+private:
+    RunoutEquity& _breakdown;
+    CardSet _board;
+};
+
+/**
+ * true if every hand of the query is complete and off the board, so its
+ * showdowns can be awarded from the evaluations of a batch.  Two hold'em
+ * hands are left to enumerateHeadsUp, whose integer counts cost less
+ * than the evaluations they would share.
+ */
+bool batchable (const vector<CardDistribution>& dists,
+                const CardSet& board,
+                const PokerHandEvaluator& peval)
+{
+    if (board.size() > peval.boardSize())
+        return false;
+    if (dists.size() == 2 && typeid(peval) == typeid(HoldemHandEvaluator))
+        return false;
+    for (size_t i=0; i<dists.size(); i++)
+        for (size_t h=0; h<dists[i].size(); h++)
+            if (dists[i][h].size() != peval.handSize() || dists[i][h].intersects (board))
+                return false;
+    return true;
+}
+
+/**
+ * The queries of one game and board, which share the runouts and the
+ * evaluations of their hands.  Each query's hand tuples are listed once,
+ * with the cards they hold and their weight, as indices into the
+ * distinct hands of the batch.
+ */
+class ShowdownBatch
+{
+public:
+    ShowdownBatch (const CardSet& board, const PokerHandEvaluator& peval, bool exact)
+        : _board (board)
+        , _peval (peval)
+        , _exact (exact)
+        , _hands ()
+        , _index ()
+        , _queries ()
+    {}
+
+    void add (const vector<CardDistribution>& dists)
+    {
+        _queries.push_back (QueryTuples());
+        QueryTuples& query = _queries.back();
+        query.nplayers = dists.size();
+        vector<size_t> indices (dists.size());
+        addTuples (dists, 0, 0, 1.0, 1, indices, query);
+    }
+
+    /**
+     * Deal every runout and award the tuples of each query which it
+     * leaves live, in the order of add.
+     */
+    vector<vector<EquityResult> > enumerate () const
+    {
+        vector<vector<EquityResult> > results;
+        vector<vector<PokerHandEvaluation> > tupleEvals;
+        for (size_t q=0; q<_queries.size(); q++)
+        {
+            results.push_back (vector<EquityResult> (_queries[q].nplayers, EquityResult()));
+            tupleEvals.push_back (vector<PokerHandEvaluation> (_queries[q].nplayers));
+        }
+
+        vector<uint64_t> live;
+        for (size_t c=0; c<STANDARD_DECK_SIZE; c++)
+            if (!_board.contains (Card (c)))
+                live.push_back (UINT64_C(1) << c);
+        const size_t ndeal = _peval.boardSize() - _board.size();
+
+        vector<PokerHandEvaluation> evals (_hands.size());
+        combinations cc (live.size(), ndeal);
+        do
+        {
+            uint64_t runout = _board.mask();
+            for (size_t i=0; i<ndeal; i++)
+                runout |= live[cc[i]];
+            const CardSet runoutCards (runout);
+
+            // each hand once, as evaluateShowdown would
+            const bool low = _peval.lowPossible (runoutCards);
+            for (size_t h=0; h<_hands.size(); h++)
+            {
+                if (_hands[h].mask() & runout)
+                    continue;
+                evals[h] = low ? _peval.evaluateHand (_hands[h], runoutCards)
+                               : _peval.evaluateHighHand (_hands[h], runoutCards);
+            }
+
+            for (size_t q=0; q<_queries.size(); q++)
+            {
+                const QueryTuples& query = _queries[q];
+                vector<PokerHandEvaluation>& showdown = tupleEvals[q];
+                for (size_t t=0; t<query.masks.size(); t++)
+                {
+                    if (query.masks[t] & runout)
+                        continue;
+                    const size_t * hands = &query.hands[t*query.nplayers];
+                    for (size_t i=0; i<query.nplayers; i++)
+                        showdown[i] = evals[hands[i]];
+                    if (_exact)
+                        _peval.awardShowdownExact (showdown, results[q], query.units[t]);
+                    else
+                        _peval.awardShowdown (showdown, results[q], query.weights[t]);
+                }
+            }
+        }
+        while (cc.next ());
+
+        if (_exact)
+            for (size_t q=0; q<results.size(); q++)
+                for (size_t i=0; i<results[q].size(); i++)
+                    results[q][i].setExactShares ();
+        return results;
+    }
+
+private:
+    struct QueryTuples
+    {
+        size_t nplayers;
+        vector<uint64_t> masks;
+        vector<double> weights;
+        vector<ExactShares> units;
+        vector<size_t> hands;
+    };
+
+    size_t handIndex (const CardSet& hand)
+    {
+        std::map<CardSet, size_t>::const_iterator it = _index.find (hand);
+        if (it != _index.end())
+            return it->second;
+        _index[hand] = _hands.size();
+        _hands.push_back (hand);
+        return _hands.size()-1;
+    }
+
+    void addTuples (const vector<CardDistribution>& dists, size_t player, uint64_t used,
+                    double weight, ExactShares units, vector<size_t>& indices, QueryTuples& query)
+    {
+        if (player == dists.size())
+        {
+            query.masks.push_back (used);
+            query.weights.push_back (weight);
+            query.units.push_back (units);
+            query.hands.insert (query.hands.end(), indices.begin(), indices.end());
+            return;
+        }
+        const CardDistribution& dist = dists[player];
+        for (size_t h=0; h<dist.size(); h++)
+        {
+            const CardSet& hand = dist[h];
+            if (hand.mask() & used)
+                continue;
+            indices[player] = handIndex (hand);
+            addTuples (dists, player+1, used | hand.mask(), weight*dist[hand],
+                       _exact ? units*static_cast<ExactShares> (dist[hand]) : 0,
+                       indices, query);
+        }
+    }
+
+    CardSet _board;
+    const PokerHandEvaluator& _peval;
+    bool _exact;
+    vector<CardSet> _hands;
+    std::map<CardSet, size_t> _index;
+    vector<QueryTuples> _queries;
+};
+
+/**
+ * Samples the showdowns of dists against opponents random hands.  Each
+ * sample picks a hand from every distribution by weight, starting over
+ * when the hands collide, and then deals the missing cards of the hands,
+ * the opponents and the board from the cards left.
+ */
+vector<EquityResult> sampleRandomOpponents (const vector<CardDistribution>& dists,
+                                            size_t opponents,
+                                            const CardSet& board,
+                                            const PokerHandEvaluator& peval,
+                                            size_t samples,
+                                            uint64_t seed,
+                                            bool exact)
+{
+    const size_t ndists = dists.size();
+    const size_t nplayers = ndists + opponents;
+    const size_t handsize = peval.handSize();
+    const size_t boardsize = peval.boardSize();
+    if (nplayers*handsize + boardsize > STANDARD_DECK_SIZE)
+        throw runtime_error("ShowdownEnumerator, too many hands for one deck");
+    if (exact && nplayers > EXACT_SHARES_MAX_HANDS)
+        throw runtime_error("ShowdownEnumerator, too many hands for exact shares");
+
+    vector<vector<double> > cumulative (ndists);
+    for (size_t i=0; i<ndists; i++)
+    {
+        double sum = 0.0;
+        for (size_t h=0; h<dists[i].size(); h++)
+            cumulative[i].push_back (sum += dists[i][dists[i][h]]);
+        if (sum <= 0.0)
+            throw runtime_error("ShowdownEnumerator, no weight for player "
+                                + boost::lexical_cast<string>(i));
+    }
+
+    std::mt19937_64 rng (seed);
+    std::uniform_real_distribution<double> unit (0.0, 1.0);
+    vector<uint64_t> deck;
+    for (size_t c=0; c<STANDARD_DECK_SIZE; c++)
+        deck.push_back (UINT64_C(1) << c);
+
+    vector<CardSet> hands (nplayers);
+    vector<PokerHandEvaluation> evals (nplayers);
+    vector<EquityResult> results (nplayers, EquityResult());
+    const size_t MAX_COLLISIONS = 1000;
+    size_t collisions = 0;
+    for (size_t t=0; t<samples; )
+    {
+        uint64_t used = board.mask();
+        bool collided = false;
+        for (size_t i=0; i<ndists && !collided; i++)
+        {
+            const double u = unit (rng) * cumulative[i].back();
+            size_t h = std::upper_bound (cumulative[i].begin(), cumulative[i].end(), u)
+                - cumulative[i].begin();
+            hands[i] = dists[i][std::min (h, dists[i].size()-1)];
+            collided = (hands[i].mask() & used) != 0;
+            used |= hands[i].mask();
+        }
+        if (collided)
+        {
+            if (++collisions == MAX_COLLISIONS)
+                throw runtime_error("ShowdownEnumerator, the hands keep colliding");
+            continue;
+        }
+        collisions = 0;
+
+        // draw from the cards not yet dealt, passing over the used ones
+        size_t next = 0;
+        auto deal = [&] (size_t count) -> uint64_t
+        {
+            uint64_t cards = 0;
+            while (count > 0)
+            {
+                std::uniform_int_distribution<size_t> pick (next, deck.size()-1);
+                std::swap (deck[next], deck[pick (rng)]);
+                const uint64_t card = deck[next++];
+                if (card & used)
+                    continue;
+                cards |= card;
+                used |= card;
+                count--;
+            }
+            return cards;
+        };
+        for (size_t i=0; i<ndists; i++)
+            if (hands[i].size() < handsize)
+                hands[i] = CardSet (hands[i].mask() | deal (handsize - hands[i].size()));
+        for (size_t i=ndists; i<nplayers; i++)
+            hands[i] = CardSet (deal (handsize));
+        const CardSet runout (board.mask() | deal (boardsize - board.size()));
+
+        if (exact)
+            peval.evaluateShowdownExact (hands, runout, evals, results);
+        else
+            peval.evaluateShowdown (hands, runout, evals, results);
+        t++;
+    }
+    if (exact)
+        for (size_t i=0; i<nplayers; i++)
+            results[i].setExactShares ();
+    return results;
+}
+
+/**
+ * Awards the showdowns of an enumeration of one of the stud games to the
+ * others, see calculateStudEquity.  Every game's evaluation is made from
+ * the high, and the low of the game enumerated: the ace to five low of
+ * 'q', or the eight or better low of 'e'.  The enumeration's own results
+ * are those of its game.
+ */
+class StudGamesVisitor : public ShowdownVisitor
+{
+public:
+    StudGamesVisitor (const string& games, char enumerated, size_t nplayers, bool exact)
+        : _games (games)
+        , _enumerated (enumerated)
+        , _exact (exact)
+        , _pevals ()
+        , _results (games.size(), vector<EquityResult> (nplayers, EquityResult()))
+        , _evals (nplayers)
+    {
+        for (size_t g=0; g<games.size(); g++)
+            _pevals.push_back (PokerHandEvaluator::alloc (string (1, games[g])));
+    }
+
+    virtual void visit (const vector<CardSet>& hands,
+                        const CardSet&,
+                        double weight,
+                        ExactShares units,
+                        const vector<PokerHandEvaluation>& evals,
+                        const vector<EquityResult>&)
+    {
+        for (size_t g=0; g<_games.size(); g++)
+        {
+            if (_games[g] == _enumerated)
+                continue;
+            for (size_t i=0; i<evals.size(); i++)
+                _evals[i] = evaluation (_games[g], hands[i], evals[i]);
+            if (_exact)
+                _pevals[g]->awardShowdownExact (_evals, _results[g], units);
+            else
+                _pevals[g]->awardShowdown (_evals, _results[g], weight);
+        }
+    }
+
+    vector<vector<EquityResult> > results (const vector<EquityResult>& enumerated)
+    {
+        for (size_t g=0; g<_games.size(); g++)
+        {
+            if (_games[g] == _enumerated)
+                _results[g] = enumerated;
+            else if (_exact)
+                for (size_t i=0; i<_results[g].size(); i++)
+                    _results[g][i].setExactShares ();
+        }
+        return _results;
+    }
+
+private:
+    static PokerHandEvaluation evaluation (char game,
+                                           const CardSet& hand,
+                                           const PokerHandEvaluation& eval)
+    {
+        switch (game)
+        {
+            case 's':
+                return PokerHandEvaluation (eval.high());
+            case 'r':
+                return PokerHandEvaluation (eval.low());
+            default:
+            {
+                // the best ace to five low is eight or better whenever five
+                // ranks of eight or under are there to make it
+                const int EIGHT_LOW_RANKS = 0x107F;
+                int ranks = hand.rankMask() & EIGHT_LOW_RANKS;
+                size_t nranks = 0;
+                for (; ranks; ranks &= ranks-1)
+                    nranks++;
+                return PokerHandEvaluation (eval.high(),
+                                            nranks >= 5 ? eval.low() : PokerEvaluation());
+            }
+        }
+    }
+
+    string _games;
+    char _enumerated;
+    bool _exact;
+    vector<boost::shared_ptr<PokerHandEvaluator> > _pevals;
+    vector<vector<EquityResult> > _results;
+    vector<PokerHandEvaluation> _evals;
+};
+
+/**
+ * 64 bit FNV-1a
+ */
+uint64_t fnv1a (const string& key)
+{
+    uint64_t hash = UINT64_C(14695981039346656037);
+    for (size_t i=0; i<key.size(); i++)
+    {
+        hash ^= static_cast<unsigned char>(key[i]);
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+}
+
 ShowdownEnumerator::ShowdownEnumerator ()
+    : _useSuitSymmetry (false)
+    , _useExactShares (false)
+    , _checkpointFile ()
+    , _checkpointInterval (60.0)
+    , _shardIndex (0)
+    , _shardCount (1)
 {
 
 }
 
+void ShowdownEnumerator::setCheckpoint (const string& filename, double interval)
+{
+    _checkpointFile = filename;
+    _checkpointInterval = interval;
+}
+
+void ShowdownEnumerator::setShard (size_t index, size_t count)
+{
+    if (count == 0 || index >= count)
+        throw runtime_error("ShowdownEnumerator, bad shard "
+                            + boost::lexical_cast<string>(index) + "/"
+                            + boost::lexical_cast<string>(count));
+    _shardIndex = index;
+    _shardCount = count;
+}
+
 vector<EquityResult> ShowdownEnumerator::calculateEquity (const vector<CardDistribution>& dists,
                                                           const CardSet& board,
                                                           boost::shared_ptr<PokerHandEvaluator> peval) const
 {
-    if (peval.get() == NULL)
-        throw runtime_error("ShowdownEnumerator, null evaluator");
+    checkQuery (dists, peval.get());
+    if (useRangeShowdown (dists, board, *peval))
+        return rangeShowdown (dists, board, *peval);
+    EquityCheckpoint state;
+    state.fingerprint = fingerprint (dists, board, *peval);
+    if (_shardCount == 1)
+        return enumerate (dists, oneBoard (CardDistribution (board)), peval, state, NULL, NULL, NULL, NULL);
+
+    ShardRange range = shardRange (dists, board, *peval);
+    state.outer = range.startOuter;
+    state.inner = range.startInner;
+    return enumerate (dists, oneBoard (CardDistribution (board)), peval, state, &range, NULL, NULL, NULL);
+}
+
+vector<EquityResult> ShowdownEnumerator::calculateEquity (const vector<CardDistribution>& dists,
+                                                          const CardDistribution& boards,
+                                                          boost::shared_ptr<PokerHandEvaluator> peval) const
+{
+    checkQuery (dists, peval.get());
+    checkBoards (boards, *peval);
+    if (!_checkpointFile.empty() || _shardCount > 1)
+        throw runtime_error("ShowdownEnumerator, board distributions are not checkpointed or sharded");
+    EquityCheckpoint state;
+    return enumerate (dists, oneBoard (boards), peval, state, NULL, NULL, NULL, NULL);
+}
+
+vector<vector<EquityResult> >
+ShowdownEnumerator::calculateEquityBatch (const vector<Query>& queries) const
+{
+    if (!_checkpointFile.empty() || _shardCount > 1)
+        throw runtime_error("ShowdownEnumerator, batches are not checkpointed or sharded");
+
+    // the batchable queries by game and board, in the order given
+    std::map<string, vector<size_t> > groups;
+    vector<string> order;
+    for (size_t q=0; q<queries.size(); q++)
+    {
+        const Query& query = queries[q];
+        checkQuery (query.dists, query.peval.get());
+        if (!batchable (query.dists, query.board, *query.peval) ||
+                useRangeShowdown (query.dists, query.board, *query.peval))
+            continue;
+        const string key = query.peval->str() + "/" + query.board.str();
+        if (groups[key].empty())
+            order.push_back (key);
+        groups[key].push_back (q);
+    }
+
+    vector<vector<EquityResult> > results (queries.size());
+    vector<bool> done (queries.size(), false);
+    for (size_t g=0; g<order.size(); g++)
+    {
+        const vector<size_t>& group = groups[order[g]];
+        if (group.size() < 2)
+            continue;
+        const Query& first = queries[group[0]];
+        ShowdownBatch batch (first.board, *first.peval, _useExactShares);
+        for (size_t i=0; i<group.size(); i++)
+        {
+            const Query& query = queries[group[i]];
+            if (_useExactShares)
+                checkExactWeights (query.dists, oneBoard (CardDistribution (query.board)).boards,
+                                   CardSet (), query.peval->handSize(), query.peval->boardSize());
+            batch.add (query.dists);
+        }
+        vector<vector<EquityResult> > answers = batch.enumerate ();
+        for (size_t i=0; i<group.size(); i++)
+        {
+            results[group[i]].swap (answers[i]);
+            done[group[i]] = true;
+        }
+    }
+
+    for (size_t q=0; q<queries.size(); q++)
+        if (!done[q])
+            results[q] = calculateEquity (queries[q].dists, queries[q].board, queries[q].peval);
+    return results;
+}
+
+vector<vector<EquityResult> >
+ShowdownEnumerator::calculateStudEquity (const vector<CardDistribution>& dists,
+                                         const CardSet& board,
+                                         const string& games) const
+{
+    if (games.empty())
+        throw runtime_error("ShowdownEnumerator, no stud games");
+    for (size_t g=0; g<games.size(); g++)
+        if (string ("sreq").find (games[g]) == string::npos)
+            throw runtime_error("ShowdownEnumerator, not a stud game: " + string (1, games[g]));
+    if (!_checkpointFile.empty() || _shardCount > 1)
+        throw runtime_error("ShowdownEnumerator, stud games together are not checkpointed or sharded");
+
+    // The pass is enumerated for the game whose lows give every other
+    // game's, the high is common to all.  Razz needs the ace to five low
+    // of 'q', without which it is cheaper dealt by ranks on its own.
+    char enumerated = 'r';
+    for (const char * game = "seq"; *game; game++)
+        if (games.find (*game) != string::npos)
+            enumerated = *game;
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc (string (1, enumerated));
+    checkQuery (dists, peval.get());
+
+    string shared;
+    for (size_t g=0; g<games.size(); g++)
+        if ((games[g] != 'r' || enumerated == 'q') && shared.find (games[g]) == string::npos)
+            shared += games[g];
+
+    vector<vector<EquityResult> > sharedResults;
+    if (!shared.empty())
+    {
+        StudGamesVisitor visitor (shared, enumerated, dists.size(), _useExactShares);
+        EquityCheckpoint state;
+        sharedResults = visitor.results (enumerate (dists, oneBoard (CardDistribution (board)), peval,
+                                                    state, NULL, &visitor, NULL, NULL));
+    }
+
+    vector<vector<EquityResult> > results;
+    for (size_t g=0; g<games.size(); g++)
+    {
+        const size_t k = shared.find (games[g]);
+        if (k != string::npos)
+            results.push_back (sharedResults[k]);
+        else
+            results.push_back (calculateEquity (dists, board, PokerHandEvaluator::alloc ("r")));
+    }
+    return results;
+}
+
+vector<EquityResult> ShowdownEnumerator::calculateRandomEquity (const vector<CardDistribution>& dists,
+                                                                size_t opponents,
+                                                                const CardSet& board,
+                                                                boost::shared_ptr<PokerHandEvaluator> peval,
+                                                                size_t samples,
+                                                                uint64_t seed) const
+{
+    // a default distribution is a random hand
+    vector<CardDistribution> players (dists);
+    players.resize (dists.size() + opponents);
+    checkQuery (players, peval.get());
+    if (samples == 0)
+        return calculateEquity (players, board, peval);
+
+    if (!_checkpointFile.empty() || _shardCount > 1)
+        throw runtime_error("ShowdownEnumerator, sampled equity is not checkpointed or sharded");
+    if (board.size() > peval->boardSize())
+        throw runtime_error("ShowdownEnumerator, board too large: " + board.str());
+    for (size_t i=0; i<dists.size(); i++)
+        for (size_t h=0; h<dists[i].size(); h++)
+            if (dists[i][h].size() > peval->handSize())
+                throw runtime_error("ShowdownEnumerator, hand too large: " + dists[i][h].str());
+    return sampleRandomOpponents (dists, opponents, board, *peval, samples, seed, _useExactShares);
+}
+
+vector<vector<EquityResult> >
+ShowdownEnumerator::calculateMultiBoardEquity (const vector<CardDistribution>& dists,
+                                               const vector<CardSet>& boards,
+                                               boost::shared_ptr<PokerHandEvaluator> peval) const
+{
+    checkQuery (dists, peval.get());
+    if (boards.empty() || peval->boardSize() == 0)
+        throw runtime_error("ShowdownEnumerator, no boards");
+    if (!_checkpointFile.empty() || _shardCount > 1)
+        throw runtime_error("ShowdownEnumerator, multiple boards are not checkpointed or sharded");
+
+    // the cards on every board are dealt once, the rest of each board
+    // is its own
+    BoardSlots slots;
+    slots.common = boards[0];
+    for (size_t b=1; b<boards.size(); b++)
+        slots.common = CardSet (slots.common.mask() & boards[b].mask());
+    CardSet seen;
+    for (size_t b=0; b<boards.size(); b++)
+    {
+        checkBoards (CardDistribution (boards[b]), *peval);
+        CardSet own (boards[b].mask() & ~slots.common.mask());
+        if (seen.intersects (own))
+            throw runtime_error("ShowdownEnumerator, boards share only some cards: " + boards[b].str());
+        seen |= own;
+        slots.boards.push_back (CardDistribution (own));
+    }
+    if (boards.size() == 1)
+        slots = oneBoard (CardDistribution (boards[0]));
+
+    vector<vector<EquityResult> > perBoard;
+    EquityCheckpoint state;
+    enumerate (dists, slots, peval, state, NULL, NULL, &perBoard, NULL);
+    return perBoard;
+}
+
+vector<double> ShowdownEnumerator::calculateExpectedChips (const vector<CardDistribution>& dists,
+                                                           const CardSet& board,
+                                                           boost::shared_ptr<PokerHandEvaluator> peval,
+                                                           const vector<SidePot>& pots) const
+{
+    checkQuery (dists, peval.get());
+    if (!_checkpointFile.empty() || _shardCount > 1)
+        throw runtime_error("ShowdownEnumerator, side pots are not checkpointed or sharded");
+    const uint32_t everyone = (dists.size() < 32) ? (1u << dists.size())-1 : ~0u;
+    double total = 0.0;
+    for (size_t p=0; p<pots.size(); p++)
+    {
+        if (pots[p].players == 0 || (pots[p].players & ~everyone) != 0 || pots[p].amount < 0.0)
+            throw runtime_error("ShowdownEnumerator, bad side pot "
+                                + boost::lexical_cast<string>(p));
+        total += pots[p].amount;
+    }
+
+    EquityCheckpoint state;
+    vector<EquityResult> results = enumerate (dists, oneBoard (CardDistribution (board)), peval,
+                                              state, NULL, NULL, NULL, &pots);
+
+    // every runout hands out all the chips, so the chips handed out over
+    // those in the pots is the weight of the runouts
+    double awarded = 0.0;
+    for (size_t i=0; i<results.size(); i++)
+        awarded += results[i].winShares + results[i].tieShares;
+    vector<double> chips (dists.size(), 0.0);
+    for (size_t i=0; awarded > 0.0 && i<results.size(); i++)
+        chips[i] = (results[i].winShares + results[i].tieShares)*total/awarded;
+    return chips;
+}
+
+PartialEquity ShowdownEnumerator::calculatePartialEquity (const vector<CardDistribution>& dists,
+                                                          const CardSet& board,
+                                                          boost::shared_ptr<PokerHandEvaluator> peval,
+                                                          bool resume) const
+{
+    checkQuery (dists, peval.get());
+    ShardRange range = shardRange (dists, board, *peval);
+    PartialEquity ret;
+    ret.fingerprint = fnv1a (queryKey (dists, board, *peval));
+    ret.exact       = _useExactShares;
+    ret.shard       = _shardIndex;
+    ret.nshards     = _shardCount;
+    ret.begin       = range.begin;
+    ret.end         = range.end;
+    ret.total       = range.total;
+    ret.game        = peval->str();
+    ret.board       = board.str();
+    for (size_t i=0; i<dists.size(); i++)
+        ret.hands.push_back (dists[i].str());
+    ret.results     = resume ? resumeEquity (dists, board, peval)
+                             : calculateEquity (dists, board, peval);
+    return ret;
+}
+
+vector<EquityResult> ShowdownEnumerator::resumeEquity (const vector<CardDistribution>& dists,
+                                                       const CardSet& board,
+                                                       boost::shared_ptr<PokerHandEvaluator> peval) const
+{
+    checkQuery (dists, peval.get());
+    if (_checkpointFile.empty())
+        throw runtime_error("ShowdownEnumerator, no checkpoint file to resume from");
+    EquityCheckpoint state;
+    state.read (_checkpointFile);
+    if (state.fingerprint != fingerprint (dists, board, *peval) ||
+        state.results.size() != dists.size())
+        throw runtime_error("ShowdownEnumerator, checkpoint is for a different query");
+    if (_shardCount == 1)
+        return enumerate (dists, oneBoard (CardDistribution (board)), peval, state, NULL, NULL, NULL, NULL);
+
+    ShardRange range = shardRange (dists, board, *peval);
+    return enumerate (dists, oneBoard (CardDistribution (board)), peval, state, &range, NULL, NULL, NULL);
+}
+
+RunoutEquity ShowdownEnumerator::calculateRunoutEquity (const vector<CardDistribution>& dists,
+                                                       const CardSet& board,
+                                                       boost::shared_ptr<PokerHandEvaluator> peval,
+                                                       size_t depth) const
+{
+    checkQuery (dists, peval.get());
+    if (!_checkpointFile.empty() || _shardCount > 1)
+        throw runtime_error("ShowdownEnumerator, runout breakdowns are not checkpointed or sharded");
+    RunoutEquity breakdown (dists.size(), depth);
+    BreakdownVisitor visitor (breakdown, board);
+    EquityCheckpoint state;
+    breakdown.results = enumerate (dists, oneBoard (CardDistribution (board)), peval,
+                                   state, NULL, &visitor, NULL, NULL);
+    if (_useExactShares)
+        breakdown.setExactShares ();
+    return breakdown;
+}
+
+vector<EquityResult> ShowdownEnumerator::visitShowdowns (const vector<CardDistribution>& dists,
+                                                         const CardSet& board,
+                                                         boost::shared_ptr<PokerHandEvaluator> peval,
+                                                         ShowdownVisitor& visitor) const
+{
+    checkQuery (dists, peval.get());
+    if (!_checkpointFile.empty() || _shardCount > 1)
+        throw runtime_error("ShowdownEnumerator, visited showdowns are not checkpointed or sharded");
+    EquityCheckpoint state;
+    return enumerate (dists, oneBoard (CardDistribution (board)), peval, state, NULL, &visitor, NULL, NULL);
+}
+
+EquityMatrix ShowdownEnumerator::calculateMatrix (const vector<CardDistribution>& dists,
+                                                  const CardSet& board,
+                                                  boost::shared_ptr<PokerHandEvaluator> peval) const
+{
+    checkQuery (dists, peval.get());
+    if (dists.size() != 2)
+        throw runtime_error("ShowdownEnumerator, the equity matrix is for two players");
+    return rangeMatrix (dists[0], dists[1], board, *peval);
+}
+
+ShowdownEnumerator::BoardSlots ShowdownEnumerator::oneBoard (const CardDistribution& boards)
+{
+    BoardSlots slots;
+    slots.boards.push_back (boards);
+    return slots;
+}
+
+/**
+ * Two ranges of complete hands in a single pot game go to rangeShowdown,
+ * which evaluates each hand once per board instead of once per pairing.
+ * Each board costs it a sort of both ranges, so boards with cards to come
+ * are only worth it when the ranges are wide; narrow ranges do better
+ * with the per tuple shortcuts of enumerate.  Checkpoints, shards and
+ * exact shares need enumerate, so every shard of a query is a slice of
+ * the same enumeration whether or not it is checkpointed.
+ */
+bool ShowdownEnumerator::useRangeShowdown (const vector<CardDistribution>& dists,
+                                           const CardSet& board,
+                                           const PokerHandEvaluator& peval) const
+{
+    if (dists.size() < 2 || dists.size() > EXACT_SHARES_MAX_HANDS ||
+            !_checkpointFile.empty() || _shardCount > 1 || _useExactShares ||
+            peval.evaluationSize() != 1)
+        return false;
+    if (dists.size() > 2 && peval.handSize() > 2)
+        return false;
+    for (size_t i=0; i<dists.size(); i++)
+    {
+        if (dists[i].size() == 0)
+            return false;
+        for (size_t j=0; j<dists[i].size(); j++)
+            if (dists[i][j].size() != peval.handSize())
+                return false;
+    }
+    if (board.size() >= peval.boardSize())
+        return true;
+
+    // the tuples the enumeration would visit, against the hands and the
+    // tuples of all but the widest range that rangeShowdown visits
+    size_t widest = 0;
+    double hands = 0.0;
+    double tuples = 1.0;
+    for (size_t i=0; i<dists.size(); i++)
+    {
+        hands += dists[i].size();
+        tuples *= dists[i].size();
+        if (dists[i].size() > dists[widest].size())
+            widest = i;
+    }
+    double walked = hands;
+    if (dists.size() > 2)
+        walked += tuples/dists[widest].size();
+    return tuples >= RANGE_SHOWDOWN_WIDTH*walked;
+}
+
+/**
+ * The runouts are numbered hand tuple by hand tuple, in enumeration
+ * order, and the numbering is cut into equal slices.  A slice usually
+ * starts and stops part way through a hand tuple.  Tuples which enumerate
+ * deals in one go are not cut, they go to the slice holding their first
+ * runout.
+ */
+ShowdownEnumerator::ShardRange ShowdownEnumerator::shardRange (const vector<CardDistribution>& dists,
+                                                               const CardSet& board,
+                                                               const PokerHandEvaluator& peval) const
+{
+    ShardRange range;
+    range.total = 0;
+    countRunouts (dists, board, peval.handSize(), peval.boardSize(),
+                  [&] (uint64_t count) { range.total += count; return true; });
+
+    // the first total%count shards get one extra runout
+    const uint64_t base = range.total/_shardCount;
+    const uint64_t extra = range.total%_shardCount;
+    range.begin = _shardIndex*base + std::min<uint64_t>(_shardIndex, extra);
+    range.end = range.begin + base + (_shardIndex < extra ? 1 : 0);
+
+    // an offset at the very end is a position past the last tuple, which
+    // is where the enumeration stops anyway
+    range.startOuter = range.stopOuter = ~UINT64_C(0);
+    range.startInner = range.stopInner = 0;
+    uint64_t outer = 0;
+    uint64_t seen = 0;
+    countRunouts (dists, board, peval.handSize(), peval.boardSize(),
+                  [&] (uint64_t count)
+                  {
+                      if (range.startOuter == ~UINT64_C(0) && range.begin < seen+count)
+                      {
+                          range.startOuter = outer;
+                          range.startInner = range.begin-seen;
+                      }
+                      if (range.end < seen+count)
+                      {
+                          range.stopOuter = outer;
+                          range.stopInner = range.end-seen;
+                          return false;
+                      }
+                      seen += count;
+                      outer++;
+                      return true;
+                  });
+    return range;
+}
+
+/**
+ * Everything which determines the runouts and the results of a query.
+ */
+string ShowdownEnumerator::queryKey (const vector<CardDistribution>& dists,
+                                     const CardSet& board,
+                                     const PokerHandEvaluator& peval) const
+{
+    string key = peval.str() + "|" + typeid(peval).name() + "|" + board.str();
+    key += (_useSuitSymmetry ? "|symmetric" : "|full");
+    key += (_useExactShares ? "|exact" : "|real");
+    if (!peval.usesSuits ())
+        key += "|suitless";
+    else if (peval.flushSize () > 0)
+        key += "|ranks";
+    if (dists.size() == 2 && typeid(peval) == typeid(HoldemHandEvaluator))
+        key += "|headsup";
+    if (!identicalPlayers (dists).empty())
+        key += "|identical";
+    for (size_t i=0; i<dists.size(); i++)
+        key += "|" + dists[i].str();
+    return key;
+}
+
+/**
+ * A hash of the query and the shard, used to make sure checkpoints are
+ * only resumed by the query which wrote them.
+ */
+uint64_t ShowdownEnumerator::fingerprint (const vector<CardDistribution>& dists,
+                                          const CardSet& board,
+                                          const PokerHandEvaluator& peval) const
+{
+    string key = queryKey (dists, board, peval);
+    if (_shardCount > 1)
+        key += "|shard " + boost::lexical_cast<string>(_shardIndex)
+            + "/" + boost::lexical_cast<string>(_shardCount);
+    return fnv1a (key);
+}
+
+vector<EquityResult> ShowdownEnumerator::enumerate (const vector<CardDistribution>& dists,
+                                                    const BoardSlots& slots,
+                                                    boost::shared_ptr<PokerHandEvaluator> peval,
+                                                    EquityCheckpoint& state,
+                                                    const ShardRange* range,
+                                                    ShowdownVisitor* visitor,
+                                                    vector<vector<EquityResult> >* perBoard,
+                                                    const vector<SidePot>* pots) const
+{
     assert(dists.size() > 1);
     const size_t ndists = dists.size();
     vector<EquityResult> results(ndists, EquityResult());
+    if (!state.results.empty())
+        results = state.results;
     size_t handsize = peval->handSize();
 
     // the dsizes vector is a list of the sizes of the player hand
@@ -41,77 +1428,571 @@ vector<EquityResult> ShowdownEnumerator::calculateEquity (const vector<CardDistr
         dsizes.push_back (dists[i].size());
     }
 
-    // need to figure out the board stuff, we'll be rolling the board into
-    // the partitions to make enumeration easier down the line.
+    // the boards are rolled into the partitions as more slots, each
+    // dealt from its board distribution like a player's hand from theirs,
+    // so a board and a hand which share a card are skipped like any two
+    // hands.  The cards common to the boards are dead throughout.  Games
+    // without a board deal no slot for it.
     size_t nboards = 0;
     size_t boardsize = peval->boardSize();
+    const vector<CardDistribution>& boards = slots.boards;
+    const CardSet& common = slots.common;
     if (boardsize > 0)
-        nboards++;
+    {
+        nboards = boards.size();
+        for (size_t b=0; b<nboards; b++)
+            dsizes.push_back (boards[b].size());
+    }
+    const size_t nslots = ndists+nboards;
+    const CardSet fixedBoard = boards[0][0];
 
     // for the most part, these are allocated here to avoid contant stack
     // reallocation as we cycle through the inner loops
     SimpleDeck deck;
-    CardSet dead;
-    double weight;
-    vector<CardSet>             ehands         (ndists+nboards);
-    vector<size_t>              parts          (ndists+nboards);
-    vector<CardSet>             cardPartitions (ndists+nboards);
+    DeadCards dead (deck);
+    vector<CardSet>             ehands         (nslots);
+    vector<size_t>              parts          (nslots);
+    vector<CardSet>             cardPartitions (nslots);
     vector<PokerHandEvaluation> evals          (ndists);         // NO BOARD
+    vector<double>              weights        (nslots);
+    vector<double>              prefixWeight   (nslots+1, 1.0);  // running products
+    vector<uint64_t>            unitWeights    (nslots);         // exact shares only
+    vector<ExactShares>         prefixUnits    (nslots+1, 1);
+
+    // Omaha evaluators work from prepared hands and boards.  The hole card
+    // pairs of a hand from a distribution are prepared when the hand comes
+    // into the tuple, and the board triples once per runout.
+    const OmahaPreparedEvaluator* omaha =
+        dynamic_cast<const OmahaPreparedEvaluator*>(peval.get());
+    vector<OmahaHand>           omahaHands     (omaha ? ndists : 0);
+    OmahaBoard                  omahaBoard;
+
+    // exact shares are multiplied by the hand weights, which must be
+    // whole numbers.  Side pots are counted in chips, which are not.
+    const bool exact = _useExactShares && pots == NULL;
+    if (exact)
+        checkExactWeights (dists, boards, common, handsize, boardsize);
+    auto finish = [&] ()
+    {
+        if (exact)
+            for (size_t i=0; i<ndists; i++)
+                results[i].setExactShares ();
+    };
 
     // copy quickness
     CardSet * copydest = &ehands[0];
     CardSet * copysrc = &cardPartitions[0];
-    size_t ncopy = (ndists+nboards)*sizeof(CardSet);
-    Odometer o(dsizes);
+    size_t ncopy = nslots*sizeof(CardSet);
+
+    // Evaluators which ignore suits see the same showdown for every choice
+    // of suits, so the runouts are dealt as multisets of ranks instead of
+    // sets of cards.  This covers whatever suit symmetry could save.  A
+    // tuple is then dealt in one go, so checkpoints are only taken between
+    // tuples, and a shard takes the whole of every such tuple whose first
+    // runout falls in its slice.
+    const bool suitless = !peval->usesSuits();
+
+    // Evaluators for the flush games only see the suits when someone can
+    // make a flush.  Hand tuples where no runout gives anyone flushSize
+    // cards of a suit are dealt by ranks as well.
+    const size_t flushSize = peval->flushSize();
+
+    // Two complete hold'em hands are counted by enumerateHeadsUp, which
+    // deals the board with nested loops instead of a PartitionEnumerator.
+    const bool headsUp = ndists == 2 && typeid(*peval) == typeid(HoldemHandEvaluator);
+
+    // A visitor sees each runout's own cards and shares, so it is only
+    // called on the card by card path, and without the symmetries which
+    // stand one runout in for others.
+    const bool perRunout = visitor != NULL;
+
+    // With more than one board each runout is a showdown on every board,
+    // into that board's own results.  The runouts are dealt card by card,
+    // and the evaluations of a board are kept until its cards or the
+    // hands change, so the boards dealt first, which change least often,
+    // are evaluated once for all the boards dealt after them.
+    const bool multiBoard = nboards > 1;
+
+    // With side pots the players are not alike, and the shares are the
+    // chips of each pot a player is in, so the shortcuts which count the
+    // shares of a single pot are left out.
+    const bool sidePots = pots != NULL;
+    vector<vector<EquityResult> > boardShares (multiBoard ? nboards : 0,
+                                               vector<EquityResult> (ndists, EquityResult()));
+    vector<vector<PokerHandEvaluation> > boardEvals (multiBoard ? nboards : 0,
+                                                     vector<PokerHandEvaluation> (ndists));
+    vector<CardSet> shownHands (multiBoard ? ndists : 0);
+    vector<CardSet> shownBoards (nboards);
+    bool shown = false;
+
+    // Suit symmetry.  The symmetries are the suit permutations which
+    // leave the whole problem unchanged.  We only visit hand tuples which
+    // are canonical under them, and then only runouts which are canonical
+    // under the symmetries which fix the hand tuple (the stabilizer).
+    // Every canonical (hands, runout) pair stands for its whole orbit,
+    // which has size |symmetries|/|stabilizer of the pair|.
+    vector<SuitPermutation> symmetries (1, SuitPermutation());
+    if (_useSuitSymmetry && !suitless && !perRunout)
+        symmetries = findSymmetries (dists, boards, common);
+    const bool symmetric = symmetries.size() > 1;
+    vector<SuitPermutation> stabilizer;
+    vector<size_t> handSlots;
+    vector<size_t> drawSlots;
+    for (size_t i=0; i<nslots; i++)
+        handSlots.push_back (i);
+
+    // Players with identical distributions can trade places, so of the
+    // k! orderings of their hands only the one where the hands increase
+    // is dealt, weighted by k!, and the shares are spread back evenly
+    // over the group.  Complete hands are ordered per tuple.  Players
+    // which are dealt all their cards, like random hands, are ordered per
+    // runout, where the runouts are dealt card by card.  This is not
+    // combined with suit symmetry, which takes precedence.
+    const vector<vector<size_t> > groups =
+        (symmetric || perRunout || multiBoard || sidePots) ? vector<vector<size_t> >() : identicalPlayers (dists);
+    vector<uint64_t> orderings;
+    for (size_t g=0; g<groups.size(); g++)
+        orderings.push_back (factorial (groups[g].size()));
+    vector<bool> byTuple (groups.size(), false);
+    vector<bool> byRunout (groups.size(), false);
+    vector<EquityResult> scratch (groups.empty() ? 0 : ndists, EquityResult());
+    vector<EquityResult>& acc = groups.empty() ? results : scratch;
+    vector<EquityResult> runoutShares (perRunout ? ndists : 0, EquityResult());
+    vector<EquityResult>& shares = perRunout ? runoutShares : acc;
+
+    // move the shares in scratch into the results, evenly over the
+    // players of the groups which were ordered.  Every share carries the
+    // factor k! of its group, so the division is exact.
+    auto fold = [&] (bool runouts)
+    {
+        if (groups.empty())
+            return;
+        for (size_t g=0; g<groups.size(); g++)
+        {
+            if (!byTuple[g] && !(runouts && byRunout[g]))
+                continue;
+            const vector<size_t>& group = groups[g];
+            EquityResult sum;
+            for (size_t i=0; i<group.size(); i++)
+            {
+                sum += scratch[group[i]];
+                scratch[group[i]] = EquityResult();
+            }
+            const size_t k = group.size();
+            for (size_t i=0; i<group.size(); i++)
+            {
+                EquityResult& r = results[group[i]];
+                r.winShares += sum.winShares/k;
+                r.tieShares += sum.tieShares/k;
+                r.winUnits  += sum.winUnits/k;
+                r.tieUnits  += sum.tieUnits/k;
+            }
+        }
+        for (size_t i=0; i<ndists; i++)
+        {
+            results[i] += scratch[i];
+            scratch[i] = EquityResult();
+        }
+    };
+
+    // The hand tuples are walked in Gray code order so only one player's
+    // hand changes per step.  The dead cards, the deck, and the weight
+    // product are updated for that one hand rather than rebuilt.
+    GrayOdometer o(dsizes);
+    uint64_t outer = state.outer;
+    uint64_t resumeInner = state.inner;
+    if (outer >= o.count())
+    {
+        finish ();
+        return results;
+    }
+
+    // A shard stops part way through a tuple, and the next shard starts
+    // there.  The deck is put in a fixed order in the tuples where shards
+    // meet so the runout numbers mean the same cards to both.
+    const uint64_t stopOuter = range ? range->stopOuter : ~UINT64_C(0);
+    const uint64_t stopInner = range ? range->stopInner : 0;
+    const bool sortAtStart = range && state.deck.empty();
+    // put the current hand of slot i, or the current board, into the
+    // partitions
+    auto deal = [&] (size_t i)
+    {
+        const CardDistribution& dist = (i < ndists) ? dists[i] : boards[i-ndists];
+        cardPartitions[i] = dist[o[i]];
+        parts[i]          = ((i < ndists) ? handsize : boardsize-common.size())-cardPartitions[i].size();
+        weights[i]        = dist[cardPartitions[i]];
+        unitWeights[i]    = static_cast<uint64_t>(weights[i]);
+        dead.insert (cardPartitions[i]);
+        if (omaha && i < ndists)
+            omahaHands[i].prepare (cardPartitions[i]);
+    };
+
+    o.seek (outer);
+    dead.insert (common);
+    for (size_t i=0; i<nslots; i++)
+    {
+        deal (i);
+        prefixWeight[i+1] = prefixWeight[i]*weights[i];
+        prefixUnits[i+1]  = prefixUnits[i]*unitWeights[i];
+    }
+    if (!state.deck.empty())
+        deck.restore (state.deck, state.live);
+    if (sortAtStart)
+        dead.sortDeck ();
+
+    // the prefix products after the slot that moves are refreshed, the
+    // last slot moves most often, so this is constant time amortized
+    auto nextTuple = [&] () -> bool
+    {
+        if (!o.next ())
+            return false;
+        outer++;
+        size_t i = o.changed ();
+        dead.remove (cardPartitions[i]);
+        deal (i);
+        for (size_t j=i; j<nslots; j++)
+        {
+            prefixWeight[j+1] = prefixWeight[j]*weights[j];
+            prefixUnits[j+1]  = prefixUnits[j]*unitWeights[j];
+        }
+        if (outer == stopOuter)
+            dead.sortDeck ();
+        return true;
+    };
+
+    // checkpoints are written from the top of the runout loop, so the
+    // position saved is the next runout to evaluate
+    typedef std::chrono::steady_clock Clock;
+    const bool checkpointing = !_checkpointFile.empty();
+    Clock::time_point lastSave = Clock::now();
+    size_t countdown = CHECKPOINT_STRIDE;
+    auto save = [&] (uint64_t inner)
+    {
+        state.outer   = outer;
+        state.inner   = inner;
+        state.live    = deck.size();
+        state.deck    = deck.codes();
+        state.results = results;
+        state.write (_checkpointFile);
+        lastSave = Clock::now();
+    };
+
     do
     {
-        // colect all the cards being used by the players, skip out in the
-        // case of card duplication
-        bool disjoint = true;
-        dead.clear ();
-        weight = 1.0;
-        for (size_t i=0; i<ndists+nboards; i++)
+        if (outer > stopOuter || (outer == stopOuter && stopInner == 0))
+            break;
+
+        // skip out in the case of card duplication
+        if (!dead.disjoint ())
+            continue;
+        double weight = prefixWeight[nslots];
+        ExactShares units = prefixUnits[nslots];
+
+        if (symmetric)
+        {
+            // skip hand tuples which are not the smallest in their orbit,
+            // and keep the permutations which fix this one
+            bool canonical = true;
+            stabilizer.clear ();
+            for (size_t s=1; canonical && s<symmetries.size(); s++)
+            {
+                int cmp = compareImage (cardPartitions, handSlots, symmetries[s]);
+                if (cmp < 0)
+                    canonical = false;
+                else if (cmp == 0)
+                    stabilizer.push_back (symmetries[s]);
+            }
+            if (!canonical)
+                continue;
+
+            // only the slots which are dealt to can be moved by the
+            // stabilizer
+            drawSlots.clear ();
+            for (size_t p=0; p<nslots; p++)
+                if (parts[p] > 0)
+                    drawSlots.push_back (p);
+        }
+
+        // only the increasing orderings of identical players
+        uint64_t runoutOrderings = 1;
+        bool increasing = true;
+        for (size_t g=0; increasing && g<groups.size(); g++)
         {
-            if (i<ndists)
+            const vector<size_t>& group = groups[g];
+            bool complete = true;
+            bool alike = true;
+            for (size_t i=0; i<group.size(); i++)
+            {
+                complete = complete && parts[group[i]] == 0;
+                alike = alike && cardPartitions[group[i]] == cardPartitions[group[0]];
+            }
+            byTuple[g] = complete;
+            byRunout[g] = !complete && alike;
+            if (complete)
+            {
+                increasing = inOrder (cardPartitions, group);
+                weight *= static_cast<double>(orderings[g]);
+                units *= orderings[g];
+            }
+            else if (alike)
+                runoutOrderings *= orderings[g];
+        }
+        if (!increasing)
+            continue;
+
+        // tuples dealt in one go belong to the shard holding their first
+        // runout, so the tuple a shard starts part way through is not its
+        const bool wholeHeadsUp = headsUp && !perRunout && !multiBoard && !sidePots &&
+                                  parts[0] == 0 && parts[1] == 0;
+        const bool byRanks = !wholeHeadsUp && !perRunout && !multiBoard &&
+                             (suitless || (flushSize > 0 &&
+                                           !flushPossible (cardPartitions, parts, ndists, nboards,
+                                                           dead.cards(), flushSize)));
+        if ((wholeHeadsUp || byRanks) && range &&
+                outer == range->startOuter && range->startInner > 0)
+            continue;
+
+        if (wholeHeadsUp)
+        {
+            if (checkpointing)
+            {
+                std::chrono::duration<double> elapsed = Clock::now() - lastSave;
+                if (elapsed.count() >= _checkpointInterval)
+                    save (0);
+            }
+            resumeInner = 0;
+            const uint64_t orbit = symmetries.size()/(stabilizer.size()+1);
+            HeadsUpCounts counts = enumerateHeadsUp (cardPartitions[0], cardPartitions[1],
+                                                     cardPartitions[ndists]);
+            if (exact)
             {
-                cardPartitions[i] = dists[i][o[i]];
-                parts[i]          = handsize-cardPartitions[i].size();
-                weight           *= dists[i][cardPartitions[i]];
+                const ExactShares pot = static_cast<ExactShares>(EXACT_SHARES_PER_POT)*units*orbit;
+                acc[0].winUnits += pot*counts.win;
+                acc[1].winUnits += pot*counts.lose;
+                acc[0].tieUnits += pot/2*counts.tie;
+                acc[1].tieUnits += pot/2*counts.tie;
             }
             else
             {
-                // this allows us to have board distributions in the future
-                cardPartitions[i] = board;
-                parts[i]          = boardsize-cardPartitions[i].size();
+                const double w = weight*static_cast<double>(orbit);
+                acc[0].winShares += w*static_cast<double>(counts.win);
+                acc[1].winShares += w*static_cast<double>(counts.lose);
+                acc[0].tieShares += 0.5*w*static_cast<double>(counts.tie);
+                acc[1].tieShares += 0.5*w*static_cast<double>(counts.tie);
             }
-            disjoint = disjoint && dead.disjoint(cardPartitions[i]);
-            dead |= cardPartitions[i];
+            fold (false);
+            continue;
         }
 
-        if (disjoint)
+        // every runout of the tuple stands for its orbit under the
+        // symmetries, when dealt by ranks
+        if (byRanks)
         {
-            deck.reset ();
-            deck.remove (dead);
-            PartitionEnumerator2 pe(deck.size(), parts);
-            do
+            const uint64_t orbit = symmetries.size()/(stabilizer.size()+1);
+            if (checkpointing)
             {
-                // we use memcpy here for a little speed bonus
-                memcpy (copydest, copysrc, ncopy);
-                for (size_t p=0; p<ndists+nboards; p++)
-                    ehands[p] |= deck.peek(pe.getMask (p));
+                std::chrono::duration<double> elapsed = Clock::now() - lastSave;
+                if (elapsed.count() >= _checkpointInterval)
+                    save (0);
+            }
+            resumeInner = 0;
+            RankRunouts runouts (deck, parts);
+            memcpy (copydest, copysrc, ncopy);
+            runouts.deal (ehands, [&] (uint64_t multiplicity)
+            {
+                const CardSet& showdownBoard = (nboards > 0) ? ehands[ndists] : fixedBoard;
+                if (sidePots)
+                    peval->evaluateShowdown (ehands, showdownBoard, evals, *pots, acc,
+                                             weight*static_cast<double>(orbit*multiplicity));
+                else if (exact)
+                    peval->evaluateShowdownExact (ehands, showdownBoard, evals, acc,
+                                                  units*orbit*multiplicity);
+                else
+                    peval->evaluateShowdown (ehands, showdownBoard, evals, acc,
+                                             weight*static_cast<double>(orbit*multiplicity));
+            });
+            fold (false);
+            continue;
+        }
+
+        PartitionEnumerator2 pe(deck.size(), parts);
+        uint64_t inner = resumeInner;
+        if (inner > 0)
+            pe.seek (inner);
+        resumeInner = 0;
+        const uint64_t innerStop = (outer == stopOuter) ? stopInner : ~UINT64_C(0);
+        size_t skipPast = 0;
+        do
+        {
+            skipPast = 0;
+            const uint64_t runout = inner++;
+            if (runout >= innerStop)
+                break;
+            if (checkpointing && --countdown == 0)
+            {
+                countdown = CHECKPOINT_STRIDE;
+                std::chrono::duration<double> elapsed = Clock::now() - lastSave;
+                if (elapsed.count() >= _checkpointInterval)
+                {
+                    fold (true);
+                    save (runout);
+                }
+            }
 
-                // TODO: do we need this if/else, or can we just use the if
-                // clause? A: need to rework tracking of whether a board is needed
-                if (nboards > 0)
-                    peval->evaluateShowdown (ehands, ehands[ndists], evals, results, weight);
+            // identical players are dealt in one order, that of the deck
+            // positions of their cards, which is as good as the order of
+            // the cards since the deck keeps its order through the tuple.
+            // The runouts which only differ from this one after the first
+            // player out of order are all out of order too, so they are
+            // skipped over.
+            if (runoutOrderings > 1)
+            {
+                size_t first = ndists;
+                for (size_t g=0; g<groups.size(); g++)
+                    for (size_t i=1; byRunout[g] && i<groups[g].size(); i++)
+                        if (!(pe.getMask (groups[g][i-1]) < pe.getMask (groups[g][i])))
+                            first = std::min (first, groups[g][i]);
+                if (first < ndists)
+                {
+                    const uint64_t block = pe.countAfter (first);
+                    inner = runout - runout%block + block;
+                    skipPast = first;
+                    continue;
+                }
+            }
+
+            // we use memcpy here for a little speed bonus
+            memcpy (copydest, copysrc, ncopy);
+            for (size_t p=0; p<nslots; p++)
+                ehands[p] |= deck.peek(pe.getMask (p));
+
+            double orbitWeight = weight;
+            ExactShares orbitUnits = units;
+            if (symmetric)
+            {
+                size_t fixed = 1;
+                bool canonical = true;
+                for (size_t s=0; canonical && s<stabilizer.size(); s++)
+                {
+                    int cmp = compareImage (ehands, drawSlots, stabilizer[s]);
+                    if (cmp < 0)
+                        canonical = false;
+                    else if (cmp == 0)
+                        fixed++;
+                }
+                if (!canonical)
+                    continue;
+                orbitWeight *= static_cast<double>(symmetries.size()/fixed);
+                orbitUnits *= symmetries.size()/fixed;
+            }
+            if (runoutOrderings > 1)
+            {
+                orbitWeight *= static_cast<double>(runoutOrderings);
+                orbitUnits *= runoutOrderings;
+            }
+
+            if (multiBoard)
+            {
+                bool handsChanged = !shown;
+                for (size_t p=0; p<ndists; p++)
+                    if (ehands[p] != shownHands[p])
+                    {
+                        handsChanged = true;
+                        shownHands[p] = ehands[p];
+                        if (omaha && parts[p] > 0)
+                            omahaHands[p].prepare (ehands[p]);
+                    }
+                shown = true;
+                for (size_t b=0; b<nboards; b++)
+                {
+                    const CardSet cards = ehands[ndists+b] | common;
+                    vector<PokerHandEvaluation>& boardEval = boardEvals[b];
+                    vector<EquityResult>& boardShare = boardShares[b];
+                    if (!handsChanged && cards == shownBoards[b])
+                    {
+                        if (exact)
+                            peval->awardShowdownExact (boardEval, boardShare, orbitUnits);
+                        else
+                            peval->awardShowdown (boardEval, boardShare, orbitWeight);
+                        continue;
+                    }
+                    shownBoards[b] = cards;
+                    if (omaha)
+                    {
+                        omahaBoard.prepare (cards);
+                        omaha->evaluatePreparedShowdown (omahaHands, omahaBoard, boardEval);
+                        if (exact)
+                            peval->awardShowdownExact (boardEval, boardShare, orbitUnits);
+                        else
+                            peval->awardShowdown (boardEval, boardShare, orbitWeight);
+                    }
+                    else if (exact)
+                        peval->evaluateShowdownExact (ehands, cards, boardEval, boardShare, orbitUnits);
+                    else
+                        peval->evaluateShowdown (ehands, cards, boardEval, boardShare, orbitWeight);
+                }
+                continue;
+            }
+
+            // the board is the last partition when there is one to deal
+            const CardSet& showdownBoard = (nboards > 0) ? ehands[ndists] : fixedBoard;
+            if (omaha)
+            {
+                // hands which are dealt to change with every runout
+                omahaBoard.prepare (showdownBoard);
+                for (size_t p=0; p<ndists; p++)
+                    if (parts[p] > 0)
+                        omahaHands[p].prepare (ehands[p]);
+                omaha->evaluatePreparedShowdown (omahaHands, omahaBoard, evals);
+                if (sidePots)
+                    peval->awardPots (evals, *pots, shares, orbitWeight);
+                else if (exact)
+                    peval->awardShowdownExact (evals, shares, orbitUnits);
                 else
-                    peval->evaluateShowdown (ehands, board, evals, results, weight);
+                    peval->awardShowdown (evals, shares, orbitWeight);
+            }
+            else if (sidePots)
+                peval->evaluateShowdown (ehands, showdownBoard, evals, *pots, shares, orbitWeight);
+            else if (exact)
+                peval->evaluateShowdownExact (ehands, showdownBoard, evals, shares, orbitUnits);
+            else
+                peval->evaluateShowdown (ehands, showdownBoard, evals, shares, orbitWeight);
+
+            if (perRunout)
+            {
+                visitor->visit (ehands, showdownBoard, orbitWeight, orbitUnits, evals, runoutShares);
+                for (size_t i=0; i<ndists; i++)
+                {
+                    acc[i] += runoutShares[i];
+                    runoutShares[i] = EquityResult();
+                }
             }
-            while (pe.next ());
         }
+        while (skipPast > 0 ? pe.skip (skipPast) : pe.next ());
+        fold (true);
     }
-    while (o.next ());
+    while (nextTuple ());
 
+    // the whole pot is the sum of the boards
+    for (size_t b=0; b<boardShares.size(); b++)
+        for (size_t i=0; i<ndists; i++)
+            results[i] += boardShares[b][i];
+    finish ();
+    if (perBoard)
+    {
+        if (multiBoard)
+            perBoard->swap (boardShares);
+        else
+            perBoard->assign (1, results);
+        for (size_t b=0; exact && multiBoard && b<perBoard->size(); b++)
+            for (size_t i=0; i<ndists; i++)
+                (*perBoard)[b][i].setExactShares ();
+    }
+    if (checkpointing)
+    {
+        outer = o.count();
+        save (0);
+    }
     return results;
 }
 
@@ -4,10 +4,16 @@
 #ifndef PENUM_SHOWDOWNENUMERATOR_H_
 #define PENUM_SHOWDOWNENUMERATOR_H_
 
+#include <string>
 #include <vector>
 #include <boost/shared_ptr.hpp>
 #include <pokerstove/peval/PokerHandEvaluator.h>
 #include "CardDistribution.h"
+#include "EquityCheckpoint.h"
+#include "EquityMatrix.h"
+#include "PartialEquity.h"
+#include "RunoutEquity.h"
+#include "ShowdownVisitor.h"
 
 namespace pokerstove
 {
@@ -17,11 +23,271 @@ public:
     ShowdownEnumerator ();
 
     /**
-     * enumerate a poker scenario, with board support
+     * enumerate a poker scenario, with board support.  Throws
+     * std::runtime_error for fewer than two players or a player with an
+     * empty distribution.  The hands of players with identical
+     * distributions are only dealt in one of their orders, so k random
+     * hands cost about 1/k! of the full enumeration.
      */
     std::vector<EquityResult> calculateEquity (const std::vector<CardDistribution>& dists,
                                                const CardSet& board,
                                                boost::shared_ptr<PokerHandEvaluator> peval) const;
+
+    /**
+     * calculateEquity over a weighted distribution of boards, such as all
+     * the paired flops, in one enumeration.  Each board is dealt out like
+     * the fixed board and weighted as the hands are, so the results are
+     * the sum of those for each board times its weight.  Boards and hands
+     * which share a card are skipped.  Throws std::runtime_error for an
+     * empty distribution, a board with more cards than the game deals, a
+     * checkpoint file or more than one shard.
+     */
+    std::vector<EquityResult> calculateEquity (const std::vector<CardDistribution>& dists,
+                                               const CardDistribution& boards,
+                                               boost::shared_ptr<PokerHandEvaluator> peval) const;
+
+    /**
+     * calculateEquity with the board dealt out more than once, as when
+     * running it twice, or in double board games.  The boards are dealt
+     * without replacement, from the cards the hands and the other boards
+     * leave.  Each board starts from its own cards, and the cards on more
+     * than one board must be on all of them, so running it twice from the
+     * turn is two boards holding the same four cards.  The results are by
+     * board, each as if that board's showdown were for the whole pot, and
+     * each hand is evaluated once per board it meets.  Throws
+     * std::runtime_error for a game without a board, a board with more
+     * cards than the game deals, boards which share only some cards, a
+     * checkpoint file or more than one shard.
+     */
+    std::vector<std::vector<EquityResult> >
+    calculateMultiBoardEquity (const std::vector<CardDistribution>& dists,
+                               const std::vector<CardSet>& boards,
+                               boost::shared_ptr<PokerHandEvaluator> peval) const;
+
+    /**
+     * The expected chips of each player in an all in with side pots, see
+     * SidePot, from one enumeration.  Each runout's hands are evaluated
+     * once, and every pot goes to the best of the players it is open to.
+     * The chips are counted in real numbers whether or not exact shares
+     * are on.  Throws std::runtime_error for a pot open to no player or
+     * to players past the last, a negative amount, a checkpoint file or
+     * more than one shard.
+     */
+    std::vector<double> calculateExpectedChips (const std::vector<CardDistribution>& dists,
+                                                const CardSet& board,
+                                                boost::shared_ptr<PokerHandEvaluator> peval,
+                                                const std::vector<SidePot>& pots) const;
+
+    /**
+     * One query of calculateEquityBatch.
+     */
+    struct Query
+    {
+        std::vector<CardDistribution> dists;
+        CardSet board;
+        boost::shared_ptr<PokerHandEvaluator> peval;
+    };
+
+    /**
+     * calculateEquity for each query, in order.  The queries of the same
+     * game and board are answered together.  Each runout is dealt once,
+     * each distinct hand is evaluated once on it, and every query holding
+     * the hand is awarded from that one evaluation.  A query with
+     * incomplete or random hands, or alone with its board, goes through
+     * calculateEquity.  Throws as calculateEquity does, and
+     * std::runtime_error with a checkpoint file or more than one shard.
+     */
+    std::vector<std::vector<EquityResult> > calculateEquityBatch (const std::vector<Query>& queries) const;
+
+    /**
+     * calculateEquity against opponents more players with random hands,
+     * whose results follow those of dists.  With no samples the opponents
+     * are enumerated with the board, as calculateEquity enumerates any
+     * random hand, so the results are exact.  Otherwise each sample draws
+     * a hand from every distribution by weight, and deals the opponents
+     * and the rest of the board from one shuffle of the live deck, with
+     * no distribution of sampled hands.  The samples start from seed.
+     * Sampled runs throw std::runtime_error with a checkpoint file or
+     * more than one shard.
+     */
+    std::vector<EquityResult> calculateRandomEquity (const std::vector<CardDistribution>& dists,
+                                                     size_t opponents,
+                                                     const CardSet& board,
+                                                     boost::shared_ptr<PokerHandEvaluator> peval,
+                                                     size_t samples=0,
+                                                     uint64_t seed=0) const;
+
+    /**
+     * calculateEquity for several of the stud games on the same deal,
+     * given by their letters: 's' stud, 'r' razz, 'e' stud/8 and 'q'
+     * stud high/low with no qualifier.  One enumeration evaluates each
+     * hand for the high and, when a low game is asked for, the ace to five
+     * low, and the games are awarded from those, the stud/8 low being the
+     * ace to five low when it is eight or better.  Razz alone with the
+     * high games is enumerated on its own, by ranks.  The results are in
+     * the order of games.  Throws std::runtime_error for any other game, a
+     * checkpoint file or more than one shard.
+     */
+    std::vector<std::vector<EquityResult> > calculateStudEquity (const std::vector<CardDistribution>& dists,
+                                                                 const CardSet& board,
+                                                                 const std::string& games) const;
+
+    /**
+     * When suit symmetry is on, only runouts which are canonical up to a
+     * permutation of the suits are evaluated.  The permutations used are
+     * those which leave every distribution and the board unchanged, and
+     * each canonical runout is weighted by the size of its orbit, so the
+     * results are the same as for the full enumeration.
+     */
+    void useSuitSymmetry (bool use)      { _useSuitSymmetry = use; }
+    bool usesSuitSymmetry () const       { return _useSuitSymmetry; }
+
+    /**
+     * When exact shares are on, the wins and ties are counted as integers,
+     * see PokerHandEvaluator::evaluateShowdownExact, and converted to
+     * shares only when the enumeration is done.  The results are then
+     * independent of the order of the enumeration, and merging shards or
+     * checkpoints is exact.  The hand weights must be whole numbers.
+     */
+    void useExactShares (bool use)       { _useExactShares = use; }
+    bool usesExactShares () const        { return _useExactShares; }
+
+    /**
+     * Save the enumeration position and the partial results to filename
+     * every interval seconds, and once more when the enumeration is done.
+     * An empty filename turns checkpointing off.
+     */
+    void setCheckpoint (const std::string& filename, double interval=60.0);
+
+    /**
+     * Continue a calculateEquity run from the checkpoint file.  The
+     * arguments must be the same as for the interrupted run, and the
+     * results are identical to those of an uninterrupted run.  Throws
+     * std::runtime_error if the checkpoint is for a different query.
+     */
+    std::vector<EquityResult> resumeEquity (const std::vector<CardDistribution>& dists,
+                                            const CardSet& board,
+                                            boost::shared_ptr<PokerHandEvaluator> peval) const;
+
+    /**
+     * Split the runouts of a query into count nearly equal slices, and
+     * compute only slice index (counting from zero) in calculateEquity,
+     * resumeEquity and calculatePartialEquity.  The split is
+     * deterministic, whether or not the shards are checkpointed, so
+     * separate processes can each compute one shard, and
+     * PartialEquity::merge adds them up.  A count of one turns sharding
+     * off.
+     */
+    void setShard (size_t index, size_t count);
+
+    /**
+     * calculateEquity for the current shard, along with the description
+     * of the query and the slice of runouts needed to merge it.  With
+     * resume, the shard is continued from the checkpoint file as in
+     * resumeEquity.
+     */
+    PartialEquity calculatePartialEquity (const std::vector<CardDistribution>& dists,
+                                          const CardSet& board,
+                                          boost::shared_ptr<PokerHandEvaluator> peval,
+                                          bool resume=false) const;
+
+    /**
+     * The heads up matrix of showdown counts between every hand of the
+     * two distributions, see EquityMatrix.  calculateEquity for any new
+     * weights on the same hands is then a matrix-vector product instead
+     * of another enumeration.  The hands must be complete and the game a
+     * single pot, as for rangeShowdown.  Throws std::runtime_error unless
+     * there are exactly two players.
+     */
+    EquityMatrix calculateMatrix (const std::vector<CardDistribution>& dists,
+                                  const CardSet& board,
+                                  boost::shared_ptr<PokerHandEvaluator> peval) const;
+
+    /**
+     * calculateEquity along with the results by the cards dealt to the
+     * board, see RunoutEquity, to a depth of one or two cards.  On a flop
+     * this gives the equity on every turn, and with depth two on every
+     * river, from the one enumeration.  The runouts are dealt card by
+     * card, without suit symmetry or the other shortcuts which deal many
+     * runouts at once.  Throws std::runtime_error with a checkpoint file
+     * or more than one shard.
+     */
+    RunoutEquity calculateRunoutEquity (const std::vector<CardDistribution>& dists,
+                                        const CardSet& board,
+                                        boost::shared_ptr<PokerHandEvaluator> peval,
+                                        size_t depth=1) const;
+
+    /**
+     * calculateEquity, calling visitor.visit with every showdown, so any
+     * other statistic of the runouts comes from the same pass, see
+     * ShowdownVisitor.  Use ShowdownVisitors for more than one.  The
+     * runouts are dealt card by card, as for calculateRunoutEquity, and
+     * calculateEquity is not slowed by the visits it does not make.
+     * Throws std::runtime_error with a checkpoint file or more than one
+     * shard.
+     */
+    std::vector<EquityResult> visitShowdowns (const std::vector<CardDistribution>& dists,
+                                              const CardSet& board,
+                                              boost::shared_ptr<PokerHandEvaluator> peval,
+                                              ShowdownVisitor& visitor) const;
+
+private:
+    /**
+     * The slice of the enumeration covered by the current shard.  The
+     * start and stop are (hand tuple, runout) positions.
+     */
+    struct ShardRange
+    {
+        uint64_t begin, end, total;
+        uint64_t startOuter, startInner;
+        uint64_t stopOuter, stopInner;
+    };
+
+    /**
+     * The boards of a query, one distribution per board dealt, with the
+     * cards common to all of them kept out of the distributions.  There
+     * is one board, and nothing in common, unless the board is dealt out
+     * more than once.
+     */
+    struct BoardSlots
+    {
+        CardSet common;
+        std::vector<CardDistribution> boards;
+    };
+
+    static BoardSlots oneBoard (const CardDistribution& boards);
+
+    bool useRangeShowdown (const std::vector<CardDistribution>& dists,
+                           const CardSet& board,
+                           const PokerHandEvaluator& peval) const;
+
+    ShardRange shardRange (const std::vector<CardDistribution>& dists,
+                           const CardSet& board,
+                           const PokerHandEvaluator& peval) const;
+
+    std::vector<EquityResult> enumerate (const std::vector<CardDistribution>& dists,
+                                         const BoardSlots& slots,
+                                         boost::shared_ptr<PokerHandEvaluator> peval,
+                                         EquityCheckpoint& state,
+                                         const ShardRange* range,
+                                         ShowdownVisitor* visitor,
+                                         std::vector<std::vector<EquityResult> >* perBoard,
+                                         const std::vector<SidePot>* pots) const;
+
+    std::string queryKey (const std::vector<CardDistribution>& dists,
+                          const CardSet& board,
+                          const PokerHandEvaluator& peval) const;
+
+    uint64_t fingerprint (const std::vector<CardDistribution>& dists,
+                          const CardSet& board,
+                          const PokerHandEvaluator& peval) const;
+
+    bool _useSuitSymmetry;
+    bool _useExactShares;
+    std::string _checkpointFile;
+    double _checkpointInterval;
+    size_t _shardIndex;
+    size_t _shardCount;
 };
 }
 
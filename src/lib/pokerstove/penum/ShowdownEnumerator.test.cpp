@@ -0,0 +1,1069 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <pokerstove/peval/Card.h>
+#include <pokerstove/peval/HoldemHandEvaluator.h>
+#include <pokerstove/peval/PokerEvaluation.h>
+#include "ShowdownEnumerator.h"
+
+using namespace pokerstove;
+using namespace std;
+
+namespace {
+
+vector<CardDistribution> makeDists(const vector<string>& hands)
+{
+    vector<CardDistribution> dists(hands.size());
+    for (size_t i=0; i<hands.size(); i++)
+        dists[i].parse(hands[i]);
+    return dists;
+}
+
+vector<EquityResult> equity(const string& game,
+                            const vector<string>& hands,
+                            const string& board,
+                            bool symmetry)
+{
+    ShowdownEnumerator showdown;
+    showdown.useSuitSymmetry(symmetry);
+    return showdown.calculateEquity(makeDists(hands), CardSet(board),
+                                    PokerHandEvaluator::alloc(game));
+}
+
+void expectSameResults(const vector<EquityResult>& expected,
+                       const vector<EquityResult>& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i=0; i<expected.size(); i++)
+    {
+        EXPECT_NEAR(expected[i].winShares, actual[i].winShares,
+                    1e-9*expected[i].winShares);
+        EXPECT_NEAR(expected[i].tieShares, actual[i].tieShares,
+                    1e-9*expected[i].tieShares);
+    }
+}
+
+/**
+ * The exact counts of actual are scale times those of expected.
+ */
+void expectUnitsEqual(const vector<EquityResult>& expected,
+                      const vector<EquityResult>& actual,
+                      ExactShares scale=1)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i=0; i<expected.size(); i++)
+    {
+        EXPECT_TRUE(scale*expected[i].winUnits == actual[i].winUnits) << "player " << i;
+        EXPECT_TRUE(scale*expected[i].tieUnits == actual[i].tieUnits) << "player " << i;
+    }
+}
+
+void expectSymmetryMatches(const string& game,
+                           const vector<string>& hands,
+                           const string& board)
+{
+    expectSameResults(equity(game, hands, board, false),
+                      equity(game, hands, board, true));
+}
+
+/**
+ * Hides the prepared Omaha interface of an evaluator, and claims to use
+ * the suits, so the enumerator takes the plain card by card path.
+ */
+class PlainEvaluator : public PokerHandEvaluator
+{
+public:
+    explicit PlainEvaluator(const string& game) : _peval(PokerHandEvaluator::alloc(game)) {}
+    explicit PlainEvaluator(boost::shared_ptr<PokerHandEvaluator> peval) : _peval(peval) {}
+
+    virtual PokerHandEvaluation evaluateHand(const CardSet& hand, const CardSet& board) const
+    {
+        return _peval->evaluateHand(hand, board);
+    }
+
+    virtual size_t handSize() const       { return _peval->handSize(); }
+    virtual size_t boardSize() const      { return _peval->boardSize(); }
+    virtual size_t evaluationSize() const { return _peval->evaluationSize(); }
+
+private:
+    boost::shared_ptr<PokerHandEvaluator> _peval;
+};
+
+/**
+ * A shortcut of the enumerator gives the same results as the card by
+ * card path of PlainEvaluator, with and without suit symmetry, and with
+ * exact shares the very same counts.
+ */
+void expectFastPathMatches(const vector<CardDistribution>& dists,
+                           const CardSet& board,
+                           boost::shared_ptr<PokerHandEvaluator> peval)
+{
+    boost::shared_ptr<PokerHandEvaluator> plain(new PlainEvaluator(peval));
+    ShowdownEnumerator showdown;
+    vector<EquityResult> expected = showdown.calculateEquity(dists, board, plain);
+    expectSameResults(expected, showdown.calculateEquity(dists, board, peval));
+    showdown.useSuitSymmetry(true);
+    expectSameResults(expected, showdown.calculateEquity(dists, board, peval));
+    showdown.useSuitSymmetry(false);
+
+    showdown.useExactShares(true);
+    vector<EquityResult> exact = showdown.calculateEquity(dists, board, peval);
+    vector<EquityResult> full = showdown.calculateEquity(dists, board, plain);
+    for (size_t i=0; i<full.size(); i++)
+    {
+        EXPECT_TRUE(full[i].winUnits == exact[i].winUnits) << board.str();
+        EXPECT_TRUE(full[i].tieUnits == exact[i].tieUnits) << board.str();
+    }
+}
+
+}
+
+TEST(ShowdownEnumerator, HoldemFlop)
+{
+    vector<EquityResult> results = equity("h", {"AcAd", "KcKd"}, "2s3s4s", false);
+    ASSERT_EQ(2, results.size());
+    // 990 turn/river combinations
+    EXPECT_DOUBLE_EQ(990.0, results[0].winShares + results[0].tieShares +
+                            results[1].winShares + results[1].tieShares);
+}
+
+TEST(ShowdownEnumerator, SuitSymmetryMonotoneFlop)
+{
+    expectSymmetryMatches("h", {"AsKs", "QsJs"}, "2s3s4s");
+    expectSymmetryMatches("h", {"AdKh", "QcQs"}, "2s3s4s");
+}
+
+TEST(ShowdownEnumerator, SuitSymmetryRandomHands)
+{
+    expectSymmetryMatches("h", {"AsKs", "."}, "Ts9s8s");
+    expectSymmetryMatches("h", {"AsKs", "QhQd", "."}, "Ts9s8s7s");
+}
+
+TEST(ShowdownEnumerator, SuitSymmetryRanges)
+{
+    expectSymmetryMatches("h", {"AsAh,AcAd,AdAh", "KsKh,KcKd,KdKh"}, "7c8d9h");
+    expectSymmetryMatches("o", {"Ac2c3d4d,Ad2d3c4c", "AhKhQsJs,AsKsQhJh"}, "5c6d7h");
+}
+
+TEST(ShowdownEnumerator, SuitSymmetryStud)
+{
+    expectSymmetryMatches("s", {"AsKsQsJsTs9s", "2c2d3c3d4h4s"}, "");
+    expectSymmetryMatches("e", {"As2s3s4h5h6h", "AcAd5c6d7c7d"}, "");
+}
+
+TEST(ShowdownEnumerator, SuitSymmetryPreflop)
+{
+    expectSymmetryMatches("h", {"AsAh", "KsKh"}, "");
+}
+
+namespace {
+
+/**
+ * A hold'em evaluator which fails after a number of evaluations, to
+ * simulate a run being killed part way through.  It deals card by card,
+ * so the run can stop part way through a hand tuple.
+ */
+class InterruptedEvaluator : public HoldemHandEvaluator
+{
+public:
+    explicit InterruptedEvaluator(size_t limit) : _limit(limit) {}
+
+    virtual PokerHandEvaluation evaluateHand(const CardSet& hand, const CardSet& board) const
+    {
+        if (_limit == 0)
+            throw std::runtime_error("interrupted");
+        _limit--;
+        return HoldemHandEvaluator::evaluateHand(hand, board);
+    }
+
+    virtual size_t flushSize() const { return 0; }
+
+private:
+    mutable size_t _limit;
+};
+
+}
+
+TEST(ShowdownEnumerator, OmahaPrepared)
+{
+    for (const string game : {"O", "o"})
+    {
+        // hands from distributions, and a partial hand which is dealt to
+        // with every runout
+        vector<vector<string>> hands = {{"AsKs2c3d,AhKh2d3c", "8h8d7h6d", "QcJcTd9c,QdJdTc9d"},
+                                        {"AsKs2c", "8h8d7h6d"}};
+        vector<string> boards = {"Kc8c4h", "Kc8c4h5d"};
+        for (size_t k=0; k<hands.size(); k++)
+        {
+            vector<CardDistribution> dists = makeDists(hands[k]);
+            CardSet board(boards[k]);
+            ShowdownEnumerator showdown;
+            vector<EquityResult> prepared =
+                showdown.calculateEquity(dists, board, PokerHandEvaluator::alloc(game));
+            boost::shared_ptr<PokerHandEvaluator> plain(new PlainEvaluator(game));
+            vector<EquityResult> expected = showdown.calculateEquity(dists, board, plain);
+            for (size_t i=0; i<expected.size(); i++)
+            {
+                EXPECT_EQ(expected[i].winShares, prepared[i].winShares) << game;
+                EXPECT_EQ(expected[i].tieShares, prepared[i].tieShares) << game;
+            }
+        }
+    }
+}
+
+TEST(ShowdownEnumerator, Suitless)
+{
+    boost::shared_ptr<PokerHandEvaluator> razz = PokerHandEvaluator::alloc("r");
+    boost::shared_ptr<PokerHandEvaluator> deuce = PokerHandEvaluator::alloc("t");
+    deuce->useSuits(false);
+    ASSERT_FALSE(razz->usesSuits());
+
+    vector<boost::shared_ptr<PokerHandEvaluator>> pevals = {razz, razz, deuce};
+    vector<vector<string>> hands = {{"As2s3s4s5s6s", "KsQsJsTs9s8s"},
+                                    {"Ah2h3c4d5d6s", "5c6c7d8h9hTc", "KsKhQdQc2c3s"},
+                                    {"2c3d4h5s", "7c6d5c4d"}};
+    for (size_t k=0; k<hands.size(); k++)
+        expectFastPathMatches(makeDists(hands[k]), CardSet(), pevals[k]);
+}
+
+TEST(ShowdownEnumerator, FlushImpossible)
+{
+    // rainbow flops, where the offsuit hands can not make a flush, mixed
+    // with hands which can
+    vector<string> games = {"h", "h", "h", "s"};
+    vector<vector<string>> hands = {{"AcKd", "QhJs"},
+                                    {"AcKd,AhKd,AsKs", "QhJs,TcTd", "8c8s,3h4h"},
+                                    {"AsKs", "QhJs"},
+                                    {"AcKdQh2s3c4d", "5c5d6h7s8h9c"}};
+    vector<string> boards = {"2c7d9h", "2c7d9h", "2c7d9h", ""};
+    for (size_t k=0; k<hands.size(); k++)
+        expectFastPathMatches(makeDists(hands[k]), CardSet(boards[k]),
+                              PokerHandEvaluator::alloc(games[k]));
+}
+
+TEST(ShowdownEnumerator, HeadsUp)
+{
+    // ranges of complete hands go through enumerateHeadsUp, the partial
+    // hand does not
+    vector<vector<string>> hands = {{"AcKd,AhKh,AsKs", "QhJs,TcTd"},
+                                    {"AsAh,AcAd,KdKh", "7s6s,7c6c"},
+                                    {"AsKs", "Qh"}};
+    vector<string> boards = {"2c7d9h", "7c8d", "Ts9s8d2s"};
+    for (size_t k=0; k<hands.size(); k++)
+        expectFastPathMatches(makeDists(hands[k]), CardSet(boards[k]),
+                              PokerHandEvaluator::alloc("h"));
+}
+
+TEST(ShowdownEnumerator, CheckpointResume)
+{
+    const string checkpoint = "ShowdownEnumerator.CheckpointResume.ckpt";
+    vector<CardDistribution> dists =
+        makeDists({"AsAh,AcAd,KdKh", "KsKh,QcQd,JhJs", "TcTd,ThTs"});
+    CardSet board("7c8d9h");
+    boost::shared_ptr<PokerHandEvaluator> full(new InterruptedEvaluator(~size_t(0)));
+
+    ShowdownEnumerator showdown;
+    vector<EquityResult> expected = showdown.calculateEquity(dists, board, full);
+
+    // kill the run part way through a hand tuple, checkpointing often
+    showdown.setCheckpoint(checkpoint, 0.0);
+    boost::shared_ptr<PokerHandEvaluator> killed(new InterruptedEvaluator(20011));
+    EXPECT_THROW(showdown.calculateEquity(dists, board, killed), std::runtime_error);
+
+    EquityCheckpoint saved;
+    saved.read(checkpoint);
+    EXPECT_GT(saved.outer + saved.inner, 0);
+
+    vector<EquityResult> resumed = showdown.resumeEquity(dists, board, full);
+    ASSERT_EQ(expected.size(), resumed.size());
+    for (size_t i=0; i<expected.size(); i++)
+    {
+        EXPECT_EQ(expected[i].winShares, resumed[i].winShares);
+        EXPECT_EQ(expected[i].tieShares, resumed[i].tieShares);
+    }
+
+    // a finished checkpoint resumes to the final answer, a different
+    // query is refused
+    vector<EquityResult> again = showdown.resumeEquity(dists, board, full);
+    EXPECT_EQ(expected[0].winShares, again[0].winShares);
+    EXPECT_THROW(showdown.resumeEquity(dists, CardSet("7c8d9s"), full), std::runtime_error);
+    std::remove(checkpoint.c_str());
+}
+
+TEST(ShowdownEnumerator, RejectsEmptyDistributions)
+{
+    // a hand which parses to nothing leaves no tuples to enumerate
+    vector<CardDistribution> dists(2);
+    dists[0].parse("AsAh,KdKh");
+    dists[1].clear();
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    ShowdownEnumerator showdown;
+    EXPECT_THROW(showdown.calculateEquity(dists, CardSet("7c8d9h"), peval), std::runtime_error);
+    EXPECT_THROW(showdown.calculatePartialEquity(dists, CardSet("7c8d9h"), peval),
+                 std::runtime_error);
+    dists.resize(1);
+    EXPECT_THROW(showdown.calculateEquity(dists, CardSet("7c8d9h"), peval), std::runtime_error);
+}
+
+TEST(ShowdownEnumerator, ShardsAddUp)
+{
+    vector<CardDistribution> dists =
+        makeDists({"AsAh,AcAd,KdKh", "KsKh,QcQd,JhJs", "TcTd,ThTs"});
+    CardSet board("7c8d9h");
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+
+    ShowdownEnumerator showdown;
+    vector<EquityResult> expected = showdown.calculateEquity(dists, board, peval);
+
+    // shard boundaries fall part way through hand tuples
+    for (size_t count : {1, 2, 7})
+    {
+        vector<PartialEquity> shards;
+        for (size_t i=0; i<count; i++)
+        {
+            showdown.setShard(i, count);
+            shards.push_back(showdown.calculatePartialEquity(dists, board, peval));
+        }
+        PartialEquity merged = PartialEquity::merge(shards);
+        EXPECT_EQ(merged.total, merged.end);
+        expectSameResults(expected, merged.results);
+
+        if (count > 1)
+        {
+            // every shard is needed, and only once
+            vector<PartialEquity> missing(shards.begin()+1, shards.end());
+            EXPECT_THROW(PartialEquity::merge(missing), std::runtime_error);
+            missing.push_back(shards[1]);
+            EXPECT_THROW(PartialEquity::merge(missing), std::runtime_error);
+        }
+    }
+
+    // partial results survive the round trip to disk, and shards of a
+    // different query are refused
+    const string filename = "ShowdownEnumerator.ShardsAddUp.part";
+    showdown.setShard(0, 2);
+    PartialEquity first = showdown.calculatePartialEquity(dists, board, peval);
+    first.write(filename);
+    PartialEquity reread;
+    reread.read(filename);
+    std::remove(filename.c_str());
+    EXPECT_EQ(first.fingerprint, reread.fingerprint);
+    EXPECT_EQ(first.end, reread.end);
+    EXPECT_EQ(first.hands, reread.hands);
+    EXPECT_EQ(first.results[1].winShares, reread.results[1].winShares);
+
+    showdown.setShard(1, 2);
+    PartialEquity other = showdown.calculatePartialEquity(dists, CardSet("7c8d9s"), peval);
+    EXPECT_THROW(PartialEquity::merge({reread, other}), std::runtime_error);
+}
+
+TEST(ShowdownEnumerator, ShardsKeepWholeTuples)
+{
+    // razz is dealt by ranks, the flop by ranks where no flush can come,
+    // and two hold'em hands by enumerateHeadsUp, a tuple at a time
+    struct Query { const char* game; vector<string> hands; const char* board; };
+    const Query queries[] = {
+        {"r", {"As2s3s4h", "KdQdJd9c"}, ""},
+        {"h", {"AsAh,AcAd,KdKh", "KsKh,QcQd,JhJs", "TcTd,ThTs"}, "7c8d9h"},
+        {"h", {"AsKs,AcKd,QhQd", "JcTc,9h9d"}, "2c7d"},
+    };
+    for (const Query& q : queries)
+    {
+        vector<CardDistribution> dists = makeDists(q.hands);
+        CardSet board(q.board);
+        boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc(q.game);
+        ShowdownEnumerator showdown;
+        showdown.useExactShares(true);
+        vector<EquityResult> expected = showdown.calculateEquity(dists, board, peval);
+        for (size_t count : {2, 4, 9})
+        {
+            vector<PartialEquity> shards;
+            for (size_t i=0; i<count; i++)
+            {
+                showdown.setShard(i, count);
+                shards.push_back(showdown.calculatePartialEquity(dists, board, peval));
+            }
+            PartialEquity merged = PartialEquity::merge(shards);
+            for (size_t i=0; i<expected.size(); i++)
+            {
+                EXPECT_TRUE(expected[i].winUnits == merged.results[i].winUnits) << q.game << " " << count;
+                EXPECT_TRUE(expected[i].tieUnits == merged.results[i].tieUnits) << q.game << " " << count;
+            }
+        }
+    }
+}
+
+TEST(ShowdownEnumerator, ShardsOfRangeShowdown)
+{
+    // the shards are slices of the enumeration, as with a checkpoint, and
+    // add up to the range showdown
+    vector<CardDistribution> dists =
+        makeDists({"AsAh,AcAd,KdKh,AsKs,7c7d", "KsKh,KcKd,AhKh,QsJs,7h7s"});
+    CardSet board("Ts9s8d2c3h");
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    ShowdownEnumerator showdown;
+    vector<EquityResult> expected = showdown.calculateEquity(dists, board, peval);
+    vector<PartialEquity> shards;
+    for (size_t i=0; i<3; i++)
+    {
+        showdown.setShard(i, 3);
+        shards.push_back(showdown.calculatePartialEquity(dists, board, peval));
+    }
+    for (size_t i=0; i<shards.size(); i++)
+        EXPECT_GT(shards[i].results[0].winShares + shards[i].results[0].tieShares, 0.0) << i;
+    expectSameResults(expected, PartialEquity::merge(shards).results);
+
+    showdown.setCheckpoint("ShowdownEnumerator.ShardsOfRangeShowdown.ckpt");
+    showdown.setShard(1, 3);
+    expectSameResults(shards[1].results, showdown.calculatePartialEquity(dists, board, peval).results);
+    std::remove("ShowdownEnumerator.ShardsOfRangeShowdown.ckpt");
+}
+
+TEST(ShowdownEnumerator, ExactShares)
+{
+    vector<CardDistribution> dists =
+        makeDists({"AsAh,AcAd,KdKh", "KsKh,QcQd,JhJs", "TcTd,ThTs"});
+    CardSet board("7c8d9h");
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+
+    ShowdownEnumerator showdown;
+    vector<EquityResult> real = showdown.calculateEquity(dists, board, peval);
+    showdown.useExactShares(true);
+    vector<EquityResult> exact = showdown.calculateEquity(dists, board, peval);
+    expectSameResults(real, exact);
+
+    // shards merge to exactly the same counts
+    vector<PartialEquity> shards;
+    for (size_t i=0; i<5; i++)
+    {
+        showdown.setShard(i, 5);
+        shards.push_back(showdown.calculatePartialEquity(dists, board, peval));
+    }
+    PartialEquity merged = PartialEquity::merge(shards);
+    for (size_t i=0; i<exact.size(); i++)
+    {
+        EXPECT_TRUE(exact[i].winUnits == merged.results[i].winUnits);
+        EXPECT_TRUE(exact[i].tieUnits == merged.results[i].tieUnits);
+        EXPECT_EQ(exact[i].winShares, merged.results[i].winShares);
+        EXPECT_EQ(exact[i].tieShares, merged.results[i].tieShares);
+    }
+
+    // fractional weights can not be counted exactly
+    showdown.setShard(0, 1);
+    dists[0][CardSet("AsAh")] = 0.5;
+    EXPECT_THROW(showdown.calculateEquity(dists, board, peval), std::runtime_error);
+}
+
+namespace {
+
+/**
+ * Players with identical distributions are enumerated in one order only.
+ * Doubling the weights of the last player makes the distributions
+ * differ, so that query is enumerated in full, and must give twice the
+ * counts.  The shares of the identical players come out equal.
+ */
+void expectIdenticalMatches(const string& game,
+                            const vector<string>& hands,
+                            const string& board)
+{
+    vector<CardDistribution> dists = makeDists(hands);
+    vector<CardDistribution> doubled = dists;
+    CardDistribution& last = doubled.back();
+    for (size_t i=0; i<last.size(); i++)
+        last[last[i]] *= 2.0;
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc(game);
+
+    ShowdownEnumerator showdown;
+    showdown.useExactShares(true);
+    vector<EquityResult> reduced = showdown.calculateEquity(dists, CardSet(board), peval);
+    expectUnitsEqual(reduced, showdown.calculateEquity(doubled, CardSet(board), peval), 2);
+    EXPECT_TRUE(reduced[1].winUnits == reduced.back().winUnits);
+    EXPECT_TRUE(reduced[1].tieUnits == reduced.back().tieUnits);
+
+    showdown.useExactShares(false);
+    expectSameResults(reduced, showdown.calculateEquity(dists, CardSet(board), peval));
+}
+
+}
+
+TEST(ShowdownEnumerator, IdenticalPlayers)
+{
+    // random hands are ordered runout by runout, complete hands tuple by
+    // tuple, on the heads up path as well
+    expectIdenticalMatches("h", {"AhAs", ".", "."}, "2c7c9cJsQs");
+    expectIdenticalMatches("h", {"AhAs", "KcKd,KhKs,QcQd,QhQs,JcJd,JhJs", "KcKd,KhKs,QcQd,QhQs,JcJd,JhJs"}, "2c7d9h");
+    expectIdenticalMatches("h", {"AhAs", "KcKd,KhKs,QcQd,QhQs,JcJd,JhJs", "KcKd,KhKs,QcQd,QhQs,JcJd,JhJs", "KcKd,KhKs,QcQd,QhQs,JcJd,JhJs"}, "2c7d9hTc");
+    expectIdenticalMatches("h", {"KcKd,KhKs,QcQd,QhQs,JcJd,JhJs", "KcKd,KhKs,QcQd,QhQs,JcJd,JhJs"}, "2c7d9h");
+    expectIdenticalMatches("O", {"AhAsKhKs", "QcQdJcJd,QhQsJhJs,TcTd9c9d", "QcQdJcJd,QhQsJhJs,TcTd9c9d"}, "2c7d9hJs");
+    expectIdenticalMatches("r", {"As2s3s4s5s6s7s", "8c9cTcJcQcKcAc,8d9dTdJdQdKdAd,8h9hThJhQhKhAh",
+                                  "8c9cTcJcQcKcAc,8d9dTdJdQdKdAd,8h9hThJhQhKhAh"}, "");
+
+    // shards of a reduced query add up to the whole of it
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    vector<vector<string> > queries = {
+        {"AhAs", "KcKd,KhKs,QcQd,QhQs,JcJd,JhJs", "KcKd,KhKs,QcQd,QhQs,JcJd,JhJs"},
+        {"AhAs", ".", "."}};
+    for (size_t q=0; q<queries.size(); q++)
+    {
+        vector<CardDistribution> dists = makeDists(queries[q]);
+        CardSet board(q == 0 ? "2c7d9h" : "2c7c9cJsQs");
+        ShowdownEnumerator showdown;
+        showdown.useExactShares(true);
+        vector<EquityResult> expected = showdown.calculateEquity(dists, board, peval);
+        vector<PartialEquity> shards;
+        for (size_t i=0; i<7; i++)
+        {
+            showdown.setShard(i, 7);
+            shards.push_back(showdown.calculatePartialEquity(dists, board, peval));
+        }
+        PartialEquity merged = PartialEquity::merge(shards);
+        for (size_t i=0; i<expected.size(); i++)
+        {
+            EXPECT_TRUE(expected[i].winUnits == merged.results[i].winUnits) << q;
+            EXPECT_TRUE(expected[i].tieUnits == merged.results[i].tieUnits) << q;
+        }
+    }
+}
+
+TEST(ShowdownEnumerator, RunoutBreakdown)
+{
+    vector<CardDistribution> dists = makeDists({"AsAh,KsKd", "QcQd", "JcJd,TsTh"});
+    CardSet board("7c8d9h");
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    ShowdownEnumerator showdown;
+    RunoutEquity breakdown = showdown.calculateRunoutEquity(dists, board, peval, 2);
+    expectSameResults(showdown.calculateEquity(dists, board, peval), breakdown.results);
+
+    // every turn, and the rivers after a few of them, are as if the
+    // cards were on the board
+    showdown.useExactShares(true);
+    RunoutEquity exact = showdown.calculateRunoutEquity(dists, board, peval, 2);
+    CardSet deck;
+    deck.fill();
+    deck ^= board;
+    for (size_t c=0; c<STANDARD_DECK_SIZE; c++)
+    {
+        CardSet turn(Card(static_cast<int>(c)));
+        if (!deck.contains(turn))
+            continue;
+        vector<EquityResult> expected = showdown.calculateEquity(dists, board|turn, peval);
+        for (size_t i=0; i<expected.size(); i++)
+        {
+            EXPECT_TRUE(expected[i].winUnits == exact[turn][i].winUnits) << turn.str();
+            EXPECT_TRUE(expected[i].tieUnits == exact[turn][i].tieUnits) << turn.str();
+        }
+        expectSameResults(expected, breakdown[turn]);
+        if (c % 13 != 0)
+            continue;
+        for (size_t r=c+1; r<STANDARD_DECK_SIZE; r+=5)
+        {
+            CardSet river(Card(static_cast<int>(r)));
+            if (!deck.contains(river))
+                continue;
+            expectSameResults(showdown.calculateEquity(dists, board|turn|river, peval),
+                              breakdown[turn|river]);
+        }
+    }
+    EXPECT_THROW(breakdown[CardSet("2c3c4c")], std::invalid_argument);
+
+    RunoutEquity turns = showdown.calculateRunoutEquity(dists, board, peval);
+    EXPECT_THROW(turns[CardSet("2c3c")], std::invalid_argument);
+    showdown.setShard(0, 2);
+    EXPECT_THROW(showdown.calculateRunoutEquity(dists, board, peval), std::runtime_error);
+}
+
+namespace {
+
+/**
+ * A board distribution gives the results of each of its boards times the
+ * weight of the board, exactly so with exact shares.
+ */
+void expectBoardsMatch(const string& game,
+                       const vector<string>& hands,
+                       const CardDistribution& boards,
+                       bool symmetry)
+{
+    vector<CardDistribution> dists = makeDists(hands);
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc(game);
+    ShowdownEnumerator showdown;
+    showdown.useSuitSymmetry(symmetry);
+    showdown.useExactShares(true);
+    vector<EquityResult> expected(dists.size());
+    for (size_t b=0; b<boards.size(); b++)
+    {
+        const uint64_t w = static_cast<uint64_t>(boards[boards[b]]);
+        vector<EquityResult> one = showdown.calculateEquity(dists, boards[b], peval);
+        for (size_t i=0; i<one.size(); i++)
+        {
+            expected[i].winUnits += w*one[i].winUnits;
+            expected[i].tieUnits += w*one[i].tieUnits;
+        }
+    }
+    expectUnitsEqual(expected, showdown.calculateEquity(dists, boards, peval));
+    for (size_t i=0; i<expected.size(); i++)
+        expected[i].setExactShares();
+    showdown.useExactShares(false);
+    expectSameResults(expected, showdown.calculateEquity(dists, boards, peval));
+}
+
+CardDistribution makeBoards(const string& boards)
+{
+    CardDistribution ret;
+    ret.parse(boards);
+    return ret;
+}
+
+}
+
+TEST(ShowdownEnumerator, BoardDistribution)
+{
+    // paired flops, some heavier, one of them sharing a card with a hand
+    CardDistribution flops = makeBoards("7h7s2c,QhQs5d,KcKd9h,AhAs3s,5c5h8d");
+    flops[CardSet("KcKd9h")] = 3.0;
+    flops[CardSet("5c5h8d")] = 0.0;
+    expectBoardsMatch("h", {"AhKh", "QcQd,JsJh,7c7d"}, flops, false);
+
+    // complete hands heads up, identical players, and a game without a
+    // board
+    expectBoardsMatch("h", {"AhKh", "QcQd"}, makeBoards("7h7s2c8d,QhQs5d9c,KcKd9h2s"), false);
+    expectBoardsMatch("h", {"AsKs", "QcQd,JcJd,TcTd", "QcQd,JcJd,TcTd"},
+                      makeBoards("2c7c9cJsQs,2d7d9dJhQh"), false);
+    expectBoardsMatch("O", {"AhAsKhKs", "QcQdJcJd"}, makeBoards("2c7d9hJs,2c7c9cJs,Tc9d8h"), false);
+    expectBoardsMatch("r", {"As2s3s4s5s6s", "8c9cTcJcQcKc"}, makeBoards("."), false);
+
+    // the clubs and diamonds trade places on the boards, as on the hands
+    CardDistribution turns;
+    turns.fill(CardSet("KcKdKh2c2d7s"), 4);
+    expectBoardsMatch("h", {"AhAs", "."}, turns, true);
+
+    vector<CardDistribution> dists = makeDists({"AhKh", "QcQd"});
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    ShowdownEnumerator showdown;
+    CardDistribution none;
+    none.clear();
+    EXPECT_THROW(showdown.calculateEquity(dists, none, peval), std::runtime_error);
+    EXPECT_THROW(showdown.calculateEquity(dists, makeBoards("2c3c4c5c6c7c"), peval),
+                 std::runtime_error);
+    EXPECT_THROW(showdown.calculateEquity(makeDists({"As2s3s", "8c9cTc"}), makeBoards("2c"),
+                                          PokerHandEvaluator::alloc("r")),
+                 std::runtime_error);
+    showdown.setShard(0, 2);
+    EXPECT_THROW(showdown.calculateEquity(dists, flops, peval), std::runtime_error);
+}
+
+namespace {
+
+/**
+ * Running it k times from the board, each board's results are those of
+ * the one board, times the ways to deal the boards after it.
+ */
+void expectRunsMatch(const string& game,
+                     const vector<string>& hands,
+                     const string& board,
+                     size_t runs,
+                     uint64_t others)
+{
+    vector<CardDistribution> dists = makeDists(hands);
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc(game);
+    ShowdownEnumerator showdown;
+    showdown.useExactShares(true);
+    vector<EquityResult> one = showdown.calculateEquity(dists, CardSet(board), peval);
+    vector<CardSet> boards(runs, CardSet(board));
+    vector<vector<EquityResult> > exact = showdown.calculateMultiBoardEquity(dists, boards, peval);
+    showdown.useExactShares(false);
+    vector<vector<EquityResult> > real = showdown.calculateMultiBoardEquity(dists, boards, peval);
+    ASSERT_EQ(runs, exact.size());
+    for (size_t b=0; b<runs; b++)
+    {
+        SCOPED_TRACE(b);
+        expectUnitsEqual(one, exact[b], others);
+        expectSameResults(exact[b], real[b]);
+    }
+}
+
+}
+
+TEST(ShowdownEnumerator, MultipleBoards)
+{
+    expectRunsMatch("h", {"AhKh", "QcQd"}, "7h8d9h2c", 2, 43);
+    expectRunsMatch("h", {"AhKh", "QcQd", "."}, "7h8d9h2c", 2, 41);
+    expectRunsMatch("h", {"AhKh", "QcQd"}, "7h8d9h2c", 3, 43*42);
+    expectRunsMatch("O", {"AhAsKhKs", "QcQdJcJd"}, "7h8d9h2c", 2, 39);
+    expectRunsMatch("o", {"Ah2hKhKs", "3c4dJcJd"}, "7h8d6h2c", 2, 39);
+
+    // double board, where the clubs and diamonds can trade places, so
+    // the suit symmetry deals fewer runouts, and the boards can be swapped
+    vector<CardDistribution> dists = makeDists({"AhAs", "KcKd,QcQd"});
+    vector<CardSet> boards = {CardSet("2s3h7s9h"), CardSet("4s5h8h6s")};
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    ShowdownEnumerator showdown;
+    showdown.useExactShares(true);
+    vector<vector<EquityResult> > plain = showdown.calculateMultiBoardEquity(dists, boards, peval);
+    showdown.useSuitSymmetry(true);
+    vector<vector<EquityResult> > symmetric = showdown.calculateMultiBoardEquity(dists, boards, peval);
+    std::swap(boards[0], boards[1]);
+    vector<vector<EquityResult> > swapped = showdown.calculateMultiBoardEquity(dists, boards, peval);
+    for (size_t b=0; b<2; b++)
+        for (size_t i=0; i<dists.size(); i++)
+        {
+            EXPECT_TRUE(plain[b][i].winUnits == symmetric[b][i].winUnits);
+            EXPECT_TRUE(plain[b][i].tieUnits == symmetric[b][i].tieUnits);
+            EXPECT_TRUE(plain[b][i].winUnits == swapped[1-b][i].winUnits);
+            EXPECT_TRUE(plain[b][i].tieUnits == swapped[1-b][i].tieUnits);
+        }
+
+    boards = {CardSet("2c3d7s"), CardSet("2c4d8s"), CardSet("5h6h9h")};
+    EXPECT_THROW(showdown.calculateMultiBoardEquity(dists, boards, peval), std::runtime_error);
+    EXPECT_THROW(showdown.calculateMultiBoardEquity(makeDists({"As2s3s", "8c9cTc"}),
+                                                    vector<CardSet>(2),
+                                                    PokerHandEvaluator::alloc("r")),
+                 std::runtime_error);
+    showdown.setShard(0, 2);
+    EXPECT_THROW(showdown.calculateMultiBoardEquity(dists, vector<CardSet>(2), peval),
+                 std::runtime_error);
+}
+
+TEST(ShowdownEnumerator, ExpectedChips)
+{
+    // one pot everyone is in is the equity times the pot
+    vector<CardDistribution> dists = makeDists({"AhKh", "QcQd,JcJd", "."});
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    ShowdownEnumerator showdown;
+    vector<EquityResult> shares = showdown.calculateEquity(dists, CardSet("7h8d9h2c"), peval);
+    vector<double> chips = showdown.calculateExpectedChips(dists, CardSet("7h8d9h2c"), peval,
+                                                           vector<SidePot>(1, SidePot{7, 90.0}));
+    double total = 0.0;
+    for (size_t i=0; i<shares.size(); i++)
+        total += shares[i].winShares + shares[i].tieShares;
+    for (size_t i=0; i<shares.size(); i++)
+        EXPECT_NEAR(90.0*(shares[i].winShares + shares[i].tieShares)/total, chips[i], 1e-9);
+
+    // a main pot and a side pot, river by river, with the suit symmetry
+    // on as well
+    dists = makeDists({"AsKs", "QcQd", "JcJd"});
+    CardSet board("7h8h9h3h");
+    vector<SidePot> pots = {{7, 300.0}, {6, 200.0}};
+    vector<double> expected(dists.size(), 0.0);
+    double rivers = 0.0;
+    for (int c=0; c<static_cast<int>(STANDARD_DECK_SIZE); c++)
+    {
+        CardSet river{Card(c)};
+        vector<CardSet> hands = {dists[0][0], dists[1][0], dists[2][0]};
+        if (board.intersects(river) || hands[0].intersects(river) ||
+                hands[1].intersects(river) || hands[2].intersects(river))
+            continue;
+        vector<PokerHandEvaluation> evals(hands.size());
+        vector<EquityResult> won(hands.size(), EquityResult());
+        peval->evaluateShowdown(hands, board|river, evals, pots, won);
+        for (size_t i=0; i<hands.size(); i++)
+            expected[i] += won[i].winShares + won[i].tieShares;
+        rivers += 1.0;
+    }
+    for (int symmetry=0; symmetry<2; symmetry++)
+    {
+        showdown.useSuitSymmetry(symmetry == 1);
+        chips = showdown.calculateExpectedChips(dists, board, peval, pots);
+        for (size_t i=0; i<dists.size(); i++)
+            EXPECT_NEAR(expected[i]/rivers, chips[i], 1e-9) << i;
+    }
+
+    pots[1].players = 8;
+    EXPECT_THROW(showdown.calculateExpectedChips(dists, board, peval, pots), std::runtime_error);
+    pots[1].players = 0;
+    EXPECT_THROW(showdown.calculateExpectedChips(dists, board, peval, pots), std::runtime_error);
+}
+
+namespace {
+
+/**
+ * The weight of the runouts where player 0 makes a flush or better.
+ */
+struct Flushes
+{
+    double weight;
+
+    void visit(const vector<CardSet>&, const CardSet&, double w, ExactShares,
+               const vector<PokerHandEvaluation>& evals, const vector<EquityResult>&)
+    {
+        if (evals[0].high().type() >= FLUSH)
+            weight += w;
+    }
+};
+
+/**
+ * The shares of every showdown, and the number of showdowns.
+ */
+struct Shares
+{
+    vector<EquityResult> results;
+    size_t showdowns;
+
+    void visit(const vector<CardSet>&, const CardSet& board, double, ExactShares,
+               const vector<PokerHandEvaluation>& evals, const vector<EquityResult>& shares)
+    {
+        results.resize(evals.size(), EquityResult());
+        for (size_t i=0; i<shares.size(); i++)
+            results[i] += shares[i];
+        EXPECT_EQ(5, board.size());
+        showdowns++;
+    }
+};
+
+}
+
+TEST(ShowdownEnumerator, VisitShowdowns)
+{
+    vector<CardDistribution> dists = makeDists({"AhKh", "QcQd"});
+    CardSet board("7h8h2c");
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    ShowdownEnumerator showdown;
+    Flushes flushes = {0.0};
+    Shares shares = {vector<EquityResult>(), 0};
+    ShowdownVisitors<Flushes, Shares> both(flushes, shares);
+    vector<EquityResult> results = showdown.visitShowdowns(dists, board, peval, both);
+
+    // any of the nine hearts left makes the flush, all but the 630
+    // runouts from the 36 other cards
+    EXPECT_EQ(360.0, flushes.weight);
+    EXPECT_EQ(990, shares.showdowns);
+    expectSameResults(showdown.calculateEquity(dists, board, peval), results);
+    expectSameResults(results, shares.results);
+
+    showdown.setShard(1, 2);
+    EXPECT_THROW(showdown.visitShowdowns(dists, board, peval, both), std::runtime_error);
+}
+
+TEST(ShowdownEnumerator, ExactSharesLargeWeights)
+{
+    // ten hands of weight 100 multiply out past 64 bits
+    vector<CardDistribution> dists =
+        makeDists({"AsAh", "KsKh", "QsQh", "JsJh", "TsTh", "9s9h", "8s8h", "7s7h", "6s6h", "5s5h"});
+    for (size_t i=0; i<dists.size(); i++)
+        dists[i][dists[i][0]] = 100.0;
+    CardSet board("2c3d4c5d");
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+
+    ShowdownEnumerator showdown;
+    vector<EquityResult> real = showdown.calculateEquity(dists, board, peval);
+    showdown.useExactShares(true);
+    vector<EquityResult> exact = showdown.calculateEquity(dists, board, peval);
+    expectSameResults(real, exact);
+
+    // the same weights over every preflop runout of ten random hands
+    // could add up past what the counts hold
+    vector<CardDistribution> random(10);
+    for (size_t i=0; i<random.size(); i++)
+        random[i][CardSet()] = 100.0;
+    EXPECT_THROW(showdown.calculateEquity(random, CardSet(), peval), std::runtime_error);
+}
+
+namespace {
+
+double equityOf(const vector<EquityResult>& results, size_t player)
+{
+    double total = 0.0;
+    for (size_t i=0; i<results.size(); i++)
+        total += results[i].winShares + results[i].tieShares;
+    return (results[player].winShares + results[player].tieShares) / total;
+}
+
+}
+
+TEST(ShowdownEnumerator, RandomOpponents)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    ShowdownEnumerator showdown;
+    vector<CardDistribution> hero = makeDists({"AhAs"});
+
+    // enumerated, as for a random hand "."
+    vector<EquityResult> exact = showdown.calculateRandomEquity(hero, 1, CardSet("Kd7c2s"), peval);
+    expectSameResults(showdown.calculateEquity(makeDists({"AhAs", "."}), CardSet("Kd7c2s"), peval),
+                      exact);
+
+    vector<EquityResult> sampled =
+        showdown.calculateRandomEquity(hero, 1, CardSet("Kd7c2s"), peval, 100000, 3);
+    ASSERT_EQ(2u, sampled.size());
+    EXPECT_NEAR(100000.0, sampled[0].winShares + sampled[0].tieShares +
+                          sampled[1].winShares + sampled[1].tieShares, 1e-6);
+    EXPECT_NEAR(equityOf(exact, 0), equityOf(sampled, 0), 0.01);
+
+    // the same seed gives the same samples
+    expectSameResults(sampled,
+                      showdown.calculateRandomEquity(hero, 1, CardSet("Kd7c2s"), peval, 100000, 3));
+
+    // two opponents, with the opponents' results after the hero's
+    exact = showdown.calculateRandomEquity(hero, 2, CardSet("Kd7c2s9h3d"), peval);
+    sampled = showdown.calculateRandomEquity(hero, 2, CardSet("Kd7c2s9h3d"), peval, 100000, 5);
+    ASSERT_EQ(3u, sampled.size());
+    for (size_t i=0; i<3; i++)
+        EXPECT_NEAR(equityOf(exact, i), equityOf(sampled, i), 0.01) << "player " << i;
+
+    // from preflop, against the well known 85.2%
+    sampled = showdown.calculateRandomEquity(hero, 1, CardSet(), peval, 200000, 11);
+    EXPECT_NEAR(0.852, equityOf(sampled, 0), 0.005);
+
+    // exact shares count each sample as one whole pot
+    showdown.useExactShares(true);
+    sampled = showdown.calculateRandomEquity(hero, 2, CardSet(), peval, 1000, 1);
+    EXPECT_EQ(ExactShares(1000*EXACT_SHARES_PER_POT),
+              sampled[0].winUnits + sampled[0].tieUnits + sampled[1].winUnits +
+              sampled[1].tieUnits + sampled[2].winUnits + sampled[2].tieUnits);
+}
+
+TEST(ShowdownEnumerator, RandomOpponentsOmaha)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("O");
+    ShowdownEnumerator showdown;
+
+    // the top set against one random hand, sampled and on the river
+    // enumerated
+    vector<EquityResult> exact =
+        showdown.calculateRandomEquity(makeDists({"AhAsKhQc"}), 1, CardSet("Ad7c2s9h3d"), peval);
+    vector<EquityResult> sampled =
+        showdown.calculateRandomEquity(makeDists({"AhAsKhQc"}), 1, CardSet("Ad7c2s9h3d"), peval,
+                                       50000, 2);
+    EXPECT_NEAR(equityOf(exact, 0), equityOf(sampled, 0), 0.01);
+
+    sampled = showdown.calculateRandomEquity(makeDists({"AhAsKhKs"}), 3, CardSet(), peval, 20000, 4);
+    ASSERT_EQ(4u, sampled.size());
+    EXPECT_GT(equityOf(sampled, 0), 0.35);
+    EXPECT_LT(equityOf(sampled, 0), 0.5);
+}
+
+TEST(ShowdownEnumerator, RandomOpponentsRejectsBadQueries)
+{
+    boost::shared_ptr<PokerHandEvaluator> peval = PokerHandEvaluator::alloc("h");
+    ShowdownEnumerator showdown;
+    EXPECT_THROW(showdown.calculateRandomEquity(makeDists({"AhAs"}), 0, CardSet(), peval, 100),
+                 std::runtime_error);
+    EXPECT_THROW(showdown.calculateRandomEquity(makeDists({"AhAs"}), 30, CardSet(), peval, 100),
+                 std::runtime_error);
+    EXPECT_THROW(showdown.calculateRandomEquity(makeDists({"AhAs"}), 1, CardSet("AdKdQdJdTd9d"),
+                                                peval, 100),
+                 std::runtime_error);
+    showdown.setCheckpoint("random.chk");
+    EXPECT_THROW(showdown.calculateRandomEquity(makeDists({"AhAs"}), 1, CardSet(), peval, 100),
+                 std::runtime_error);
+}
+
+namespace {
+
+ShowdownEnumerator::Query makeQuery(const string& game,
+                                    const vector<string>& hands,
+                                    const string& board)
+{
+    ShowdownEnumerator::Query query;
+    query.dists = makeDists(hands);
+    query.board = CardSet(board);
+    query.peval = PokerHandEvaluator::alloc(game);
+    return query;
+}
+
+}
+
+TEST(ShowdownEnumerator, EquityBatch)
+{
+    vector<ShowdownEnumerator::Query> queries;
+    queries.push_back(makeQuery("h", {"AhAs", "KhQh"}, "Kd7c2s"));
+    queries.push_back(makeQuery("h", {"AhAs", "7d7h"}, "Kd7c2s"));
+    queries.push_back(makeQuery("o", {"Ac2c3d4d", "AhKhQsJs"}, "5c6d7h"));
+    queries.push_back(makeQuery("h", {"AhAs", "AcKc,AdKd,KcKh", "7d7h"}, "Kd7c2s"));
+    queries.push_back(makeQuery("h", {"AhAs", "."}, "Kd7c2s"));
+    queries.push_back(makeQuery("h", {"AhAs", "KhQh", "9c8c"}, "Kd7c2s"));
+    queries.push_back(makeQuery("h", {"AhAs", "KhQh"}, "Kd7c2s9h"));
+    queries.push_back(makeQuery("o", {"Ac2c3d4d", "AsKsQhJh"}, "5c6d7h"));
+    queries.push_back(makeQuery("o", {"Ac2c3d4d", "AsKsQhJh"}, "KcKdQs"));
+    queries.push_back(makeQuery("o", {"Ac2c3d4d", "AhAdKsQh"}, "KcKdQs"));
+
+    ShowdownEnumerator showdown;
+    for (size_t exact=0; exact<2; exact++)
+    {
+        showdown.useExactShares(exact == 1);
+        vector<vector<EquityResult> > batch = showdown.calculateEquityBatch(queries);
+        ASSERT_EQ(queries.size(), batch.size());
+        for (size_t q=0; q<queries.size(); q++)
+        {
+            SCOPED_TRACE(q);
+            vector<EquityResult> single =
+                showdown.calculateEquity(queries[q].dists, queries[q].board, queries[q].peval);
+            expectSameResults(single, batch[q]);
+            if (exact)
+                expectUnitsEqual(single, batch[q]);
+        }
+    }
+
+    // weights whose products are past what a double holds exactly count
+    // as they do in calculateEquity, and weights which are not whole
+    // numbers throw as they do there
+    vector<ShowdownEnumerator::Query> heavy;
+    heavy.push_back(makeQuery("h", {"AhAs", "KhQh", "9c8c"}, "Kd7c2s"));
+    heavy.push_back(makeQuery("h", {"AhAs", "KhQh", "7d7h"}, "Kd7c2s"));
+    for (size_t q=0; q<heavy.size(); q++)
+        for (size_t i=0; i<heavy[q].dists.size(); i++)
+            heavy[q].dists[i][heavy[q].dists[i][0]] = 8388609.0;
+    vector<vector<EquityResult> > batch = showdown.calculateEquityBatch(heavy);
+    for (size_t q=0; q<heavy.size(); q++)
+        expectUnitsEqual(showdown.calculateEquity(heavy[q].dists, heavy[q].board, heavy[q].peval),
+                         batch[q]);
+    heavy[0].dists[0][CardSet("AhAs")] = 0.5;
+    EXPECT_THROW(showdown.calculateEquity(heavy[0].dists, heavy[0].board, heavy[0].peval),
+                 std::runtime_error);
+    EXPECT_THROW(showdown.calculateEquityBatch(heavy), std::runtime_error);
+
+    showdown.setShard(0, 2);
+    EXPECT_THROW(showdown.calculateEquityBatch(queries), std::runtime_error);
+}
+
+TEST(ShowdownEnumerator, StudGames)
+{
+    const string games = "sreq";
+    const vector<vector<string> > spots = {
+        {"AsKsQsJs9c8h", "2c3d4h5h8d"},
+        {"AsKsQsJs9c8c", "2c3d4h5h8d7s", "9h9d6c6s3c3h"},
+        {"Ac2d3h4s5cKd", "AhAd8h8s7c6c"},
+        {"Ac2d3h9s9c", "AhAd8h8s7c6c"},
+    };
+    ShowdownEnumerator showdown;
+    for (size_t exact=0; exact<2; exact++)
+    {
+        showdown.useExactShares(exact == 1);
+        for (size_t s=0; s<spots.size(); s++)
+        {
+            SCOPED_TRACE(s);
+            vector<CardDistribution> dists = makeDists(spots[s]);
+            vector<vector<EquityResult> > together =
+                showdown.calculateStudEquity(dists, CardSet(), games);
+            ASSERT_EQ(games.size(), together.size());
+            for (size_t g=0; g<games.size(); g++)
+            {
+                SCOPED_TRACE(games[g]);
+                vector<EquityResult> alone = showdown.calculateEquity(
+                    dists, CardSet(), PokerHandEvaluator::alloc(string(1, games[g])));
+                expectSameResults(alone, together[g]);
+                if (exact)
+                    expectUnitsEqual(alone, together[g]);
+            }
+        }
+    }
+
+    // every game counts exactly weights whose products a double can not
+    // hold, not only the one enumerated
+    vector<CardDistribution> heavy = makeDists(spots[1]);
+    for (size_t i=0; i<heavy.size(); i++)
+        heavy[i][heavy[i][0]] = 8388609.0;
+    vector<vector<EquityResult> > together = showdown.calculateStudEquity(heavy, CardSet(), games);
+    for (size_t g=0; g<games.size(); g++)
+    {
+        SCOPED_TRACE(games[g]);
+        expectUnitsEqual(showdown.calculateEquity(heavy, CardSet(),
+                                                  PokerHandEvaluator::alloc(string(1, games[g]))),
+                         together[g]);
+    }
+
+    EXPECT_THROW(showdown.calculateStudEquity(makeDists({"AsKs", "2c3d"}), CardSet(), "sh"),
+                 std::runtime_error);
+    EXPECT_THROW(showdown.calculateStudEquity(makeDists({"AsKs", "2c3d"}), CardSet(), ""),
+                 std::runtime_error);
+}
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PENUM_SHOWDOWNVISITOR_H_
+#define PENUM_SHOWDOWNVISITOR_H_
+
+#include <tuple>
+#include <vector>
+#include <pokerstove/peval/PokerHandEvaluator.h>
+
+namespace pokerstove
+{
+/**
+ * Receives every showdown of an enumeration, see
+ * ShowdownEnumerator::visitShowdowns, to gather statistics the equity
+ * does not give, such as how often each hand makes a flush, in the same
+ * pass.
+ */
+class ShowdownVisitor
+{
+public:
+    virtual ~ShowdownVisitor () {}
+
+    /**
+     * One showdown.  The first evals.size() hands are the players', and
+     * evals holds their evaluations on the board.  The shares are those
+     * of this showdown alone, in units with exact shares, and already
+     * multiplied by the weight of the runout.  With exact shares, units
+     * is that weight counted exactly, which the double may not hold.
+     */
+    virtual void visit (const std::vector<CardSet>& hands,
+                        const CardSet& board,
+                        double weight,
+                        ExactShares units,
+                        const std::vector<PokerHandEvaluation>& evals,
+                        const std::vector<EquityResult>& shares) = 0;
+};
+
+/**
+ * Several accumulators behind one ShowdownVisitor.  An accumulator is any
+ * class with a visit method taking the arguments of
+ * ShowdownVisitor::visit, which need not be virtual.  The calls to the
+ * accumulators are bound at compile time, so the enumeration makes one
+ * virtual call per showdown however many accumulators there are.
+ *
+ *     HandTypes types;
+ *     PayoffEV ev;
+ *     ShowdownVisitors<HandTypes, PayoffEV> both (types, ev);
+ *     showdown.visitShowdowns (dists, board, peval, both);
+ */
+template <class... Accumulators>
+class ShowdownVisitors : public ShowdownVisitor
+{
+public:
+    explicit ShowdownVisitors (Accumulators&... accumulators)
+        : _accumulators (accumulators...)
+    {}
+
+    virtual void visit (const std::vector<CardSet>& hands,
+                        const CardSet& board,
+                        double weight,
+                        ExactShares units,
+                        const std::vector<PokerHandEvaluation>& evals,
+                        const std::vector<EquityResult>& shares)
+    {
+        visitFrom<0> (hands, board, weight, units, evals, shares);
+    }
+
+private:
+    template <size_t I>
+    typename std::enable_if<(I < sizeof...(Accumulators))>::type
+    visitFrom (const std::vector<CardSet>& hands,
+               const CardSet& board,
+               double weight,
+               ExactShares units,
+               const std::vector<PokerHandEvaluation>& evals,
+               const std::vector<EquityResult>& shares)
+    {
+        std::get<I> (_accumulators).visit (hands, board, weight, units, evals, shares);
+        visitFrom<I+1> (hands, board, weight, units, evals, shares);
+    }
+
+    template <size_t I>
+    typename std::enable_if<(I == sizeof...(Accumulators))>::type
+    visitFrom (const std::vector<CardSet>&,
+               const CardSet&,
+               double,
+               ExactShares,
+               const std::vector<PokerHandEvaluation>&,
+               const std::vector<EquityResult>&)
+    {
+    }
+
+    std::tuple<Accumulators&...> _accumulators;
+};
+}
+
+#endif  // PENUM_SHOWDOWNVISITOR_H_
@@ -6,6 +6,8 @@
 #define PENUM_SIMPLE_DECK_H_
 
 #include <string>
+#include <vector>
+#include <stdexcept>
 #include <algorithm>
 #include <functional>
 #include <boost/array.hpp>
@@ -45,6 +47,7 @@ public:
         {
             _deck[i] = CardSet(Card(i));
         }
+        indexPositions ();
         reset ();
     }
 
@@ -111,6 +114,65 @@ public:
         int decr = CardSet(cards | dead()).size();
         stable_partition (_deck.begin(), _deck.end(), bind2nd(isLive(), cards));
         _current = STANDARD_DECK_SIZE - decr;
+        indexPositions ();
+    }
+
+    /**
+     * Move the live cards in the set to the dealt end of the deck.  This
+     * takes time proportional to the number of cards moved, but unlike
+     * remove() it does not preserve the order of the live cards.
+     */
+    void take (const pokerstove::CardSet& cards)
+    {
+        uint64_t mask = cards.mask();
+        while (mask)
+        {
+            size_t pos = _position[lastbit(mask)];
+            mask &= mask-1;
+            if (pos < _current)
+                swapCards (pos, --_current);
+        }
+    }
+
+    /**
+     * Return dealt cards in the set to the live part of the deck, the
+     * inverse of take().
+     */
+    void putBack (const pokerstove::CardSet& cards)
+    {
+        uint64_t mask = cards.mask();
+        while (mask)
+        {
+            size_t pos = _position[lastbit(mask)];
+            mask &= mask-1;
+            if (pos >= _current)
+                swapCards (pos, _current++);
+        }
+    }
+
+    /**
+     * the card codes in deck order, live cards first
+     */
+    std::vector<uint8_t> codes () const
+    {
+        std::vector<uint8_t> ret (STANDARD_DECK_SIZE);
+        for (size_t i=0; i<STANDARD_DECK_SIZE; i++)
+            ret[i] = static_cast<uint8_t>(lastbit(_deck[i].mask()));
+        return ret;
+    }
+
+    /**
+     * restore a deck order saved with codes(), with the first live
+     * cards undealt
+     */
+    void restore (const std::vector<uint8_t>& codes, size_t live)
+    {
+        if (codes.size() != STANDARD_DECK_SIZE || live > STANDARD_DECK_SIZE)
+            throw std::runtime_error ("SimpleDeck::restore, bad deck");
+        for (size_t i=0; i<STANDARD_DECK_SIZE; i++)
+            _deck[i] = CardSet(Card(codes[i]));
+        indexPositions ();
+        _current = live;
     }
 
     /**
@@ -124,6 +186,7 @@ public:
     void shuffle ()
     {
         std::random_shuffle(_deck.begin(), _deck.end());
+        indexPositions ();
         reset (); //_current = 0;
     }
 
@@ -162,8 +225,22 @@ public:
     }
 
 private:
+    void indexPositions ()
+    {
+        for (uint8_t i=0; i<STANDARD_DECK_SIZE; i++)
+            _position[lastbit(_deck[i].mask())] = i;
+    }
+
+    void swapCards (size_t a, size_t b)
+    {
+        std::swap (_deck[a], _deck[b]);
+        _position[lastbit(_deck[a].mask())] = static_cast<uint8_t>(a);
+        _position[lastbit(_deck[b].mask())] = static_cast<uint8_t>(b);
+    }
+
     // these are the data which track info about the deck
     boost::array<CardSet,STANDARD_DECK_SIZE> _deck;
+    boost::array<uint8_t,STANDARD_DECK_SIZE> _position;  // card code -> deck index
     size_t _current;
 };
 }
@@ -38,6 +38,7 @@ public:
     virtual size_t handSize() const { return _handSize; }
     virtual size_t boardSize() const { return 0; }
     virtual size_t evaluationSize() const { return 1; }
+    virtual size_t flushSize() const { return 5; }
 
     virtual void setHandSize(size_t sz)
     {
@@ -43,6 +43,7 @@ public:
     virtual size_t handSize() const { return NUM_HOLDEM_POCKET; }
     virtual size_t boardSize() const { return BOARD_SIZE; }
     virtual size_t evaluationSize() const { return 1; }
+    virtual size_t flushSize() const { return 5; }
 };
 
 }
@@ -5,45 +5,46 @@
 #ifndef PEVAL_OMAHAEIGHTHANDEVALUATOR_H_
 #define PEVAL_OMAHAEIGHTHANDEVALUATOR_H_
 
+#include <algorithm>
 #include <boost/math/special_functions/binomial.hpp>
 #include "PokerEvaluationTables.h"
 #include "Holdem.h"
+#include "OmahaPrepared.h"
 #include "PokerHandEvaluator.h"
 
-inline int bottomRanks(int x, int n)
+namespace pokerstove
 {
-    int ret = 0;
-    for (int i=0; i<n; i++)
-    {
-        if (x==0)
-            return ret;
-        ret |= (-x & x);
-        x   ^= (-x & x);
-    }
-    return ret;
-}
-
-inline int flipAce(int ranks)
+/**
+ * The L3 and L5 tables of brec's low technique, see
+ * OmahaEightHandEvaluator::evaluateHand.  With the ace flipped to the
+ * bottom, the ranks eight and lower fit in eight bits.
+ */
+struct OmahaLowTables
 {
-    return
-        ((ranks & ~(1 << 12)) << 1) |
-        ((ranks >> 12) & 0x01);
-}
+    static const int NO_LOW = 0x100;    // worse than any five low ranks
+    uint16_t lowest3[256];
+    uint16_t lowest5[256];
 
-inline int unflipAce(int ranks)
-{
-    return
-        (ranks >> 1) |
-        ((ranks & 0x01) << 12);
-}
+    OmahaLowTables()
+    {
+        for (int v=0; v<256; v++)
+        {
+            lowest3[v] = static_cast<uint16_t>(bottomRanks(v, 3));
+            lowest5[v] = static_cast<uint16_t>(nRanksTable[v] >= 5 ? bottomRanks(v, 5) : NO_LOW);
+        }
+    }
 
+    static const OmahaLowTables& get()
+    {
+        static const OmahaLowTables tables;
+        return tables;
+    }
+};
 
-namespace pokerstove
-{
 /**
  * A specialized hand evaluator for hold'em.  Not as slow.
  */
-class OmahaEightHandEvaluator : public PokerHandEvaluator
+class OmahaEightHandEvaluator : public PokerHandEvaluator, public OmahaPreparedEvaluator
 {
 public:
 
@@ -66,69 +67,85 @@ public:
 
     virtual PokerHandEvaluation evaluateHand(const CardSet& hand, const CardSet& board) const
     {
-        PokerEvaluation eval[2];
-
-        // generate the possible sub hands, player hand candidates are all
-        // 4c2 combinations of hands cards,
-        // board candidates are all Nc3 board candidates, where N is the size
-        // of the board
-        double combos = boost::math::binomial_coefficient<double>(board.size(),3);
-        std::vector<CardSet> board_candidates(static_cast<size_t>(combos));
-        std::vector<CardSet> hand_candidates(6);
-        fillHands(hand_candidates, hand);
-        fillBoards(board_candidates, board);
+        return evaluatePrepared(OmahaHand(hand), OmahaBoard(board));
+    }
 
-        for (size_t i=0; i<hand_candidates.size(); i++)
-            for (size_t j=0; j<board_candidates.size(); j++)
+    /**
+     * The candidate hands are all 4c2 pairs of hole cards with all Nc3
+     * triples of board cards.
+     *
+     * The low is evaluated using brec's technique, see:
+     * http://groups.google.com/group/rec.gambling.poker/msg/e8a3a7698d51f04a?dmode=source
+     *
+     * Nominally, it takes 60 evaluations to find a player's Omaha-8 low -- 4C2=6
+     * sets of 2 hole cards times 5C3=10 sets of 3 board cards.  However, each of
+     * the 6 sets of hole cards can be evaluated in one multi-step operation as
+     * follows:
+     *
+     *     Let H be a bit vector (typically an integer variable) of the ranks of
+     * the two hole cards; H has 1 or 2 bits set;
+     *     Let B be a bit vector of the ranks of the five board cards; B has 2 to 5
+     * bits set
+     *     Let L3[v] be a bit vector of the lowest (up to) 3 bits set in v; L3[v]
+     * can be obtained by table lookup;
+     *     Let L5[v] be a bit vector of the lowest 5 bits set in v, or a special
+     * "no low" value to indicate that v has fewer than 5 bits set or that not all
+     * bits in v represent ranks of 8 or lower;  L5[v] can be obtained by table
+     * lookup.
+     *
+     * Then the low value, represented as a bit vector of ranks, is
+     *     L5[L3[B & (~H)] | H]
+     * where &, ~, and | represent bitwise AND, NOT, and OR respectively.  This
+     * represents the operation of finding the lowest three board ranks not present
+     * in the hole cards, and adding the hole cards to make the 5-card low hand.
+     *
+     * The table lookups for the six pairs are independent, and the best low
+     * is the smallest five rank mask (ace low), so the pairs are reduced with
+     * a min and only the winner is turned into an evaluation.
+     */
+    virtual PokerHandEvaluation evaluatePrepared(const OmahaHand& hand, const OmahaBoard& board) const
+    {
+        PokerEvaluation high;
+        for (size_t i=0; i<hand.npairs; i++)
+            for (size_t j=0; j<board.ntriples; j++)
             {
-                PokerEvaluation e = CardSet(hand_candidates[i] | board_candidates[j]).evaluateHigh();
-                if (e > eval[0])
-                    eval[0] = e;
+                PokerEvaluation e = CardSet(hand.pairs[i] | board.triples[j]).evaluateHigh();
+                if (e > high)
+                    high = e;
             }
+        if (!board.lowPossible)
+            return PokerHandEvaluation(high);
 
-        // evaluate the low using brec's technique, see:
-        // http://groups.google.com/group/rec.gambling.poker/msg/e8a3a7698d51f04a?dmode=source
-        //
-        // Nominally, it takes 60 evaluations to find a player's Omaha-8 low -- 4C2=6
-        // sets of 2 hole cards times 5C3=10 sets of 3 board cards.  However, each of
-        // the 6 sets of hole cards can be evaluated in one multi-step operation as
-        // follows:
-        //
-        //     Let H be a bit vector (typically an integer variable) of the ranks of
-        // the two hole cards; H has 1 or 2 bits set;
-        //     Let B be a bit vector of the ranks of the five board cards; B has 2 to 5
-        // bits set
-        //     Let L3[v] be a bit vector of the lowest (up to) 3 bits set in v; L3[v]
-        // can be obtained by table lookup;
-        //     Let L5[v] be a bit vector of the lowest 5 bits set in v, or a special
-        // "no low" value to indicate that v has fewer than 5 bits set or that not all
-        // bits in v represent ranks of 8 or lower;  L5[v] can be obtained by table
-        // lookup.
-        //
-        // Then the low value, represented as a bit vector of ranks, is
-        //     L5[L3[B & (~H)] | H]
-        // where &, ~, and | represent bitwise AND, NOT, and OR respectively.  This
-        // represents the operation of finding the lowest three board ranks not present
-        // in the hole cards, and adding the hole cards to make the 5-card low hand.
-
-        int bmask = flipAce(board.rankMask() & 0x107F);
-        if (nRanksTable[bmask] >= 3)
+        const OmahaLowTables& tables = OmahaLowTables::get();
+        int lows[OmahaHand::MAX_PAIRS];
+        for (size_t i=0; i<OmahaHand::MAX_PAIRS; i++)
         {
-            for (size_t i=0; i<hand_candidates.size(); i++)
-            {
-                int hmask = flipAce(hand_candidates[i].rankMask() & 0x107F);
-                if (nRanksTable[hmask] < 2)
-                    continue;
-                CardSet lowRanks(unflipAce(bottomRanks(bottomRanks(bmask & (~hmask), 3) | hmask, 5)));
-                PokerEvaluation e = lowRanks.evaluate8LowA5();
-                if (e > eval[1])
-                {
-                    eval[1] = e;
-                }
-            }
+            int hmask = hand.lowRanks[i];
+            lows[i] = tables.lowest5[tables.lowest3[board.lowRanks & ~hmask] | hmask];
         }
+        int best = OmahaLowTables::NO_LOW;
+        for (size_t i=0; i<OmahaHand::MAX_PAIRS; i++)
+            best = std::min(best, lows[i]);
+        if (best == OmahaLowTables::NO_LOW)
+            return PokerHandEvaluation(high);
+        return PokerHandEvaluation(high, CardSet(unflipAce(best)).evaluate8LowA5());
+    }
 
-        return PokerHandEvaluation(eval[0],eval[1]);
+    /**
+     * No one can make a low unless the board has three distinct ranks of
+     * eight or lower.
+     */
+    virtual bool lowPossible(const CardSet& board) const
+    {
+        return nRanksTable[board.rankMask() & 0x107F] >= 3;
+    }
+
+    virtual PokerHandEvaluation evaluateHighHand(const CardSet& hand, const CardSet& board) const
+    {
+        OmahaHand prepared(hand);
+        OmahaBoard noLow(board);
+        noLow.lowPossible = false;
+        return evaluatePrepared(prepared, noLow);
     }
 
     /**
@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "Card.h"
+#include "OmahaEightHandEvaluator.h"
+
+using namespace pokerstove;
+using namespace std;
+
+TEST(OmahaEightHandEvaluator, LowPossible)
+{
+    OmahaEightHandEvaluator oeval;
+    EXPECT_TRUE(oeval.lowPossible(CardSet("Ac2d8hKsKd")));
+    EXPECT_FALSE(oeval.lowPossible(CardSet("Ac2d9hKsKd")));
+    EXPECT_FALSE(oeval.lowPossible(CardSet("Ac2d2hAsKd")));
+
+    // no one has a low on a board which does not allow one
+    PokerHandEvaluation e = oeval.evaluateHand(CardSet("Ah2h3c4c"), CardSet("Ac2d9hKsKd"));
+    EXPECT_FALSE(e.highlow());
+}
+
+TEST(OmahaEightHandEvaluator, LowMatchesScalar)
+{
+    OmahaEightHandEvaluator oeval;
+    mt19937 rng(2012);
+    vector<int> deck(52);
+    for (int c=0; c<52; c++)
+        deck[c] = c;
+
+    for (int trial=0; trial<5000; trial++)
+    {
+        shuffle(deck.begin(), deck.end(), rng);
+        CardSet hand;
+        for (int j=0; j<4; j++)
+            hand.insert(Card(deck[j]));
+        CardSet board;
+        for (int j=0; j<3+trial%3; j++)
+            board.insert(Card(deck[4+j]));
+
+        PokerHandEvaluation e = oeval.evaluateHand(hand, board);
+        EXPECT_EQ(oeval.evaluateLow(hand, board), e.low()) << hand.str() << " " << board.str();
+        EXPECT_EQ(oeval.evaluateHighHand(hand, board).high(), e.high());
+    }
+}
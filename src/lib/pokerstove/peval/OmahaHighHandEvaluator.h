@@ -9,13 +9,14 @@
 #include "PokerEvaluationTables.h"
 #include "PokerHandEvaluator.h"
 #include "Holdem.h"
+#include "OmahaPrepared.h"
 
 namespace pokerstove
 {
 /**
  * A specialized hand evaluator for omaha.  Not as slow.
  */
-class OmahaHighHandEvaluator : public PokerHandEvaluator
+class OmahaHighHandEvaluator : public PokerHandEvaluator, public OmahaPreparedEvaluator
 {
 public:
 
@@ -27,27 +28,24 @@ public:
 
     virtual PokerHandEvaluation evaluateHand(const CardSet& hand, const CardSet& board) const
     {
-        PokerEvaluation eval[2];
-
-        // generate the possible sub hands, player hand candidates are all
-        // 4c2 combinations of hands cards,
-        // board candidates are all Nc3 board candidates, where N is the size
-        // of the board
-        double combos = boost::math::binomial_coefficient<double>(board.size(),3);
-        std::vector<CardSet> board_candidates(static_cast<size_t>(combos));
-        std::vector<CardSet> hand_candidates(6);
-        fillHands(hand_candidates, hand);
-        fillBoards(board_candidates, board);
+        return evaluatePrepared(OmahaHand(hand), OmahaBoard(board));
+    }
 
-        for (size_t i=0; i<hand_candidates.size(); i++)
-            for (size_t j=0; j<board_candidates.size(); j++)
+    /**
+     * The candidate hands are all 4c2 pairs of hole cards with all Nc3
+     * triples of board cards.
+     */
+    virtual PokerHandEvaluation evaluatePrepared(const OmahaHand& hand, const OmahaBoard& board) const
+    {
+        PokerEvaluation eval;
+        for (size_t i=0; i<hand.npairs; i++)
+            for (size_t j=0; j<board.ntriples; j++)
             {
-                PokerEvaluation e = CardSet(hand_candidates[i] | board_candidates[j]).evaluateHigh();
-                if (e > eval[0])
-                    eval[0] = e;
+                PokerEvaluation e = CardSet(hand.pairs[i] | board.triples[j]).evaluateHigh();
+                if (e > eval)
+                    eval = e;
             }
-
-        return PokerHandEvaluation(eval[0]);
+        return PokerHandEvaluation(eval);
     }
 
     virtual PokerEvaluation evaluateRanks(const CardSet& hand, const CardSet& board) const
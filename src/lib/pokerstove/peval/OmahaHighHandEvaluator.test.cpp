@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <iostream>
+#include <random>
+#include <vector>
+#include "Card.h"
 #include "OmahaHighHandEvaluator.h"
+#include "UniversalHandEvaluator.h"
 
 using namespace pokerstove;
 using namespace std;
@@ -22,3 +27,32 @@ TEST(OmahaHighHandEvaluator, RankEval)
     EXPECT_EQ(Rank("3"), eval.majorRank());
     EXPECT_EQ(Rank("2"), eval.minorRank());
 }
+
+TEST(OmahaHighHandEvaluator, PreparedMatchesUniversal)
+{
+    OmahaHighHandEvaluator oeval;
+    UniversalHandEvaluator ueval(4, 4, 3, 5, 2, &CardSet::evaluateHigh, NULL);
+    mt19937 rng(2012);
+    vector<int> deck(52);
+    for (int c=0; c<52; c++)
+        deck[c] = c;
+
+    for (int trial=0; trial<2000; trial++)
+    {
+        shuffle(deck.begin(), deck.end(), rng);
+        CardSet hand;
+        for (int j=0; j<4; j++)
+            hand.insert(Card(deck[j]));
+        CardSet board;
+        for (int j=0; j<3+trial%3; j++)
+            board.insert(Card(deck[4+j]));
+
+        OmahaHand prepared(hand);
+        OmahaBoard preparedBoard(board);
+        EXPECT_EQ(6, prepared.npairs);
+        EXPECT_EQ(board.size() == 5 ? 10 : board.size() == 4 ? 4 : 1, preparedBoard.ntriples);
+        EXPECT_EQ(ueval.evaluateHand(hand, board).high(),
+                  oeval.evaluatePrepared(prepared, preparedBoard).high())
+            << hand.str() << " " << board.str();
+    }
+}
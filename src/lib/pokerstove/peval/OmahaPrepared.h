@@ -0,0 +1,151 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PEVAL_OMAHAPREPARED_H_
+#define PEVAL_OMAHAPREPARED_H_
+
+#include <vector>
+#include "CardSet.h"
+#include "PokerEvaluationTables.h"
+#include "PokerHandEvaluation.h"
+
+inline int bottomRanks(int x, int n)
+{
+    int ret = 0;
+    for (int i=0; i<n; i++)
+    {
+        if (x==0)
+            return ret;
+        ret |= (-x & x);
+        x   ^= (-x & x);
+    }
+    return ret;
+}
+
+inline int flipAce(int ranks)
+{
+    return
+        ((ranks & ~(1 << 12)) << 1) |
+        ((ranks >> 12) & 0x01);
+}
+
+inline int unflipAce(int ranks)
+{
+    return
+        (ranks >> 1) |
+        ((ranks & 0x01) << 12);
+}
+
+namespace pokerstove
+{
+/**
+ * The ranks eight and under of a set of cards, with the ace flipped to
+ * the bottom bit, as used by the Omaha-8 low.
+ */
+inline int omahaLowRanks(const CardSet& cards)
+{
+    return flipAce(cards.rankMask() & 0x107F);
+}
+
+/**
+ * An Omaha hand broken into the two card candidates which can play, with
+ * their low ranks.  A hand is prepared once and then evaluated against
+ * every board it meets.
+ */
+struct OmahaHand
+{
+    static const size_t MAX_PAIRS = 6;
+
+    size_t npairs;
+    CardSet pairs[MAX_PAIRS];
+    int lowRanks[MAX_PAIRS];    //!< see omahaLowRanks
+
+    OmahaHand() : npairs(0) {}
+
+    explicit OmahaHand(const CardSet& hand) { prepare(hand); }
+
+    void prepare(const CardSet& hand)
+    {
+        CardSet cards[4];
+        size_t ncards = 0;
+        for (uint64_t m=hand.mask(); m && ncards<4; m&=m-1)
+            cards[ncards++] = CardSet(m & (~m+1));
+
+        npairs = 0;
+        for (size_t i=0; i<ncards; i++)
+            for (size_t j=i+1; j<ncards; j++)
+            {
+                pairs[npairs] = cards[i] | cards[j];
+                lowRanks[npairs] = omahaLowRanks(pairs[npairs]);
+                npairs++;
+            }
+        // the unused pairs can never make a low
+        for (size_t i=npairs; i<MAX_PAIRS; i++)
+        {
+            pairs[i] = CardSet();
+            lowRanks[i] = 0;
+        }
+    }
+};
+
+/**
+ * An Omaha board broken into the three card candidates which can play,
+ * with its low ranks.  A board is prepared once for all the hands in a
+ * showdown.
+ */
+struct OmahaBoard
+{
+    static const size_t MAX_TRIPLES = 10;
+
+    size_t ntriples;
+    CardSet triples[MAX_TRIPLES];
+    int lowRanks;               //!< see omahaLowRanks
+    bool lowPossible;           //!< three distinct ranks eight or under
+
+    OmahaBoard() : ntriples(0), lowRanks(0), lowPossible(false) {}
+
+    explicit OmahaBoard(const CardSet& board) { prepare(board); }
+
+    void prepare(const CardSet& board)
+    {
+        CardSet cards[5];
+        size_t ncards = 0;
+        for (uint64_t m=board.mask(); m && ncards<5; m&=m-1)
+            cards[ncards++] = CardSet(m & (~m+1));
+
+        ntriples = 0;
+        for (size_t i=0; i<ncards; i++)
+            for (size_t j=i+1; j<ncards; j++)
+                for (size_t k=j+1; k<ncards; k++)
+                    triples[ntriples++] = cards[i] | cards[j] | cards[k];
+        lowRanks = omahaLowRanks(board);
+        lowPossible = nRanksTable[lowRanks] >= 3;
+    }
+};
+
+/**
+ * Omaha evaluators which work from prepared hands and boards.  The
+ * showdown entry point evaluates every hand against one prepared board,
+ * so callers which keep the prepared hands between showdowns build the
+ * hole card pairs once per hand, and the board triples once per board.
+ * The pots are then awarded with PokerHandEvaluator::awardShowdown.
+ */
+class OmahaPreparedEvaluator
+{
+public:
+    virtual ~OmahaPreparedEvaluator() {}
+
+    virtual PokerHandEvaluation evaluatePrepared(const OmahaHand& hand,
+                                                 const OmahaBoard& board) const = 0;
+
+    void evaluatePreparedShowdown(const std::vector<OmahaHand>& hands,
+                                  const OmahaBoard& board,
+                                  std::vector<PokerHandEvaluation>& evals) const
+    {
+        for (size_t i=0; i<evals.size(); i++)
+            evals[i] = evaluatePrepared(hands[i], board);
+    }
+};
+}
+
+#endif  // PEVAL_OMAHAPREPARED_H_
@@ -28,11 +28,6 @@ PokerEvaluation::PokerEvaluation(int ecode)
     : _evalcode(ecode)
 {}
 
-int PokerEvaluation::code() const
-{
-    return _evalcode;
-}
-
 int PokerEvaluation::reducedCode() const
 {
     if (isFlipped())
@@ -57,7 +57,7 @@ public:
 
     std::string str() const;     //!< semantic meaning of the evaluation
     std::string bitstr() const;  //!< bit string of the evaluation code. debugging.
-    int code() const;            //!< the bit representation
+    int code() const { return _evalcode; }  //!< the bit representation
 
     /**
      * This is a showdown code, useful for comparing to other hands instead
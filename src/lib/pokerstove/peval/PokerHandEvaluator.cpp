@@ -2,7 +2,12 @@
  * Copyright (c) 2012 Andrew Prock. All rights reserved.
  * $Id: PokerHandEvaluator.cpp 2649 2012-06-30 04:53:24Z prock $
  */
+#include <climits>
 #include <iostream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <pokerstove/util/lastbit.h>
 #include "PokerHandEvaluator.h"
 
 using namespace std;
@@ -17,11 +22,23 @@ PokerHandEvaluator::PokerHandEvaluator()
 PokerHandEvaluator::~PokerHandEvaluator()
 {}
 
+// indexed by the number of ways a pot is split, up to ten hands in each
+// of two pots
 static double INV_LUT[] = {0,
-                           1/1.0, 1/2.0, 1/3.0, 1/4.0, 1/5.0,
-                           1/6.0, 1/7.0, 1/8.0, 1/9.0, 1/10.0
+                           1/1.0,  1/2.0,  1/3.0,  1/4.0,  1/5.0,
+                           1/6.0,  1/7.0,  1/8.0,  1/9.0,  1/10.0,
+                           1/11.0, 1/12.0, 1/13.0, 1/14.0, 1/15.0,
+                           1/16.0, 1/17.0, 1/18.0, 1/19.0, 1/20.0
                           };
 
+// the exact version of INV_LUT, in units of 1/EXACT_SHARES_PER_POT
+static uint64_t UNITS_LUT[] = {0,
+                               5040, 2520, 1680, 1260, 1008,
+                               840,  720,  630,  560,  504,
+                               0,    420,  0,    360,  0,
+                               315,  0,    280,  0,    252
+                              };
+
 /**
  * debugging util
  */
@@ -36,11 +53,9 @@ void display(const vector<CardSet>& hands,
     cout << endl;
 }
 
-void PokerHandEvaluator::evaluateShowdown(const vector<CardSet>& hands,
+size_t PokerHandEvaluator::evaluatePots(const vector<CardSet>& hands,
         const CardSet& board,
-        vector<PokerHandEvaluation>& evals,
-        vector<EquityResult>& result,
-        double weight) const
+        vector<PokerHandEvaluation>& evals) const
 {
     // this is a special trick we use.  the hands vector could actually
     // contain hands [0..n],board because of the way we step through the
@@ -50,6 +65,14 @@ void PokerHandEvaluator::evaluateShowdown(const vector<CardSet>& hands,
     size_t hsize = evals.size();
     size_t nevals = 1;
 
+    // a board which shuts out the low is checked once for everyone
+    if (!lowPossible(board))
+    {
+        for (size_t i=0; i<hsize; i++)
+            evals[i] = evaluateHighHand(hands[i], board);
+        return nevals;
+    }
+
     // gather all the evaluations
     for (size_t i=0; i<hsize; i++)
     {
@@ -61,6 +84,180 @@ void PokerHandEvaluator::evaluateShowdown(const vector<CardSet>& hands,
         if (nevals == 1 && evals[i].eval(1) > PokerEvaluation(0))
             nevals = 2;
     }
+    return nevals;
+}
+
+namespace {
+
+/**
+ * The evaluation codes of a showdown, one row per pot, packed densely so
+ * the winners can be found with a few SIMD compares.  The unused lanes
+ * hold INT_MIN, which never wins.
+ */
+struct ShowdownCodes
+{
+    static const size_t LANES = 12;
+    alignas(16) int code[2][LANES];
+
+    ShowdownCodes(const vector<PokerHandEvaluation>& evals, size_t nevals)
+    {
+        for (size_t e=0; e<nevals; e++)
+        {
+            size_t i = 0;
+            for (; i<evals.size(); i++)
+                code[e][i] = evals[i].eval(e).code();
+            for (; i<LANES; i++)
+                code[e][i] = INT_MIN;
+        }
+    }
+};
+
+#ifdef __SSE2__
+inline __m128i maxLanes(__m128i a, __m128i b)
+{
+    // SSE2 has no signed 32 bit max, so select on a compare
+    __m128i gt = _mm_cmpgt_epi32(a, b);
+    return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+}
+
+inline uint32_t laneMask(__m128i v)
+{
+    return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(v)));
+}
+#endif
+
+/**
+ * The bit mask of the lanes which hold the largest code.
+ */
+inline uint32_t winnerMask(const int* codes)
+{
+#ifdef __SSE2__
+    const __m128i a = _mm_load_si128(reinterpret_cast<const __m128i*>(codes));
+    const __m128i b = _mm_load_si128(reinterpret_cast<const __m128i*>(codes+4));
+    const __m128i c = _mm_load_si128(reinterpret_cast<const __m128i*>(codes+8));
+
+    // reduce to the max in every lane
+    __m128i m = maxLanes(maxLanes(a, b), c);
+    m = maxLanes(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = maxLanes(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return laneMask(_mm_cmpeq_epi32(a, m)) |
+           laneMask(_mm_cmpeq_epi32(b, m)) << 4 |
+           laneMask(_mm_cmpeq_epi32(c, m)) << 8;
+#else
+    int best = codes[0];
+    uint32_t mask = 1;
+    for (size_t i=1; i<ShowdownCodes::LANES; i++)
+    {
+        if (codes[i] > best)
+        {
+            best = codes[i];
+            mask = 1u << i;
+        }
+        else if (codes[i] == best)
+        {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+#endif
+}
+
+/**
+ * splitPots by a scan for the best evaluation and then for ties, for
+ * showdowns too small to pay for packing the codes.
+ */
+template <class Award>
+inline void scanPots(const vector<PokerHandEvaluation>& evals,
+                     size_t nevals,
+                     Award award)
+{
+    const size_t hsize = evals.size();
+    for (size_t e=0; e<nevals; e++)
+    {
+        PokerEvaluation maxeval = evals[0].eval(e);
+        size_t winner = 0;
+        size_t shares = 1;
+        for (size_t i=1; i<hsize; i++)
+        {
+            PokerEvaluation eval = evals[i].eval(e);
+            if (eval > maxeval)
+            {
+                shares = 1;
+                maxeval = eval;
+                winner = i;
+            }
+            else if (eval == maxeval)
+            {
+                shares++;
+            }
+        }
+        if (shares == 1)
+        {
+            award(winner, nevals, false);
+        }
+        else
+        {
+            for (size_t i=winner; i<hsize; i++)
+                if (evals[i].eval(e) == maxeval)
+                    award(i, shares*nevals, true);
+        }
+    }
+}
+
+/**
+ * Find the winners of each pot, and call award(i, ways, tie) for every
+ * hand i which wins or ties, where the hand's piece is 1/ways of the
+ * whole pot(s).  At most SHOWDOWN_KERNEL_HANDS hands.
+ */
+template <class Award>
+inline void splitPots(const vector<PokerHandEvaluation>& evals,
+                      size_t nevals,
+                      Award award)
+{
+    if (evals.size() < SHOWDOWN_KERNEL_MIN_HANDS)
+    {
+        scanPots(evals, nevals, award);
+        return;
+    }
+    ShowdownCodes codes(evals, nevals);
+    for (size_t e=0; e<nevals; e++)
+    {
+        uint32_t mask = winnerMask(codes.code[e]);
+        size_t shares = countbits(mask);
+        if (shares == 1)
+        {
+            award(lastbit(mask), nevals, false);
+        }
+        else
+        {
+            for (; mask; mask &= mask-1)
+                award(lastbit(mask), shares*nevals, true);
+        }
+    }
+}
+
+/**
+ * 2 if anyone qualifies for the second pot of a split pot game, else 1
+ */
+inline size_t potsInPlay(const vector<PokerHandEvaluation>& evals)
+{
+    for (size_t i=0; i<evals.size(); i++)
+        if (evals[i].eval(1) > PokerEvaluation(0))
+            return 2;
+    return 1;
+}
+
+/**
+ * The straightforward award, which scans the evaluations for the best
+ * hand and then again for ties.
+ */
+void awardReference(const vector<PokerHandEvaluation>& evals,
+                    size_t nevals,
+                    vector<EquityResult>& result,
+                    double weight)
+{
+    size_t hsize = evals.size();
 
     // award share(s)
     for (size_t e=0; e<nevals; e++)
@@ -96,6 +293,153 @@ void PokerHandEvaluator::evaluateShowdown(const vector<CardSet>& hands,
                     result[i].tieShares += INV_LUT[shares*nevals]*weight;
         }
     }
+}
+
+void awardShares(const vector<PokerHandEvaluation>& evals,
+                 size_t nevals,
+                 vector<EquityResult>& result,
+                 double weight)
+{
+    if (evals.size() > SHOWDOWN_KERNEL_HANDS)
+    {
+        awardReference(evals, nevals, result, weight);
+        return;
+    }
+    splitPots(evals, nevals, [&](size_t i, size_t ways, bool tie)
+    {
+        if (tie)
+            result[i].tieShares += INV_LUT[ways]*weight;
+        else
+            result[i].winShares += INV_LUT[ways]*weight;
+    });
+}
+
+void awardUnits(const vector<PokerHandEvaluation>& evals,
+                size_t nevals,
+                vector<EquityResult>& result,
+                ExactShares weight)
+{
+    if (evals.size() > EXACT_SHARES_MAX_HANDS || evals.size() > SHOWDOWN_KERNEL_HANDS)
+        throw std::runtime_error("evaluateShowdownExact, too many hands");
+    splitPots(evals, nevals, [&](size_t i, size_t ways, bool tie)
+    {
+        ExactShares units = UNITS_LUT[ways]*weight;
+        if (tie)
+            result[i].tieUnits += units;
+        else
+            result[i].winUnits += units;
+    });
+}
+
+}
+
+void PokerHandEvaluator::evaluateShowdown(const vector<CardSet>& hands,
+        const CardSet& board,
+        vector<PokerHandEvaluation>& evals,
+        vector<EquityResult>& result,
+        double weight) const
+{
+    size_t nevals = evaluatePots(hands, board, evals);
+    awardShares(evals, nevals, result, weight);
+}
+
+void PokerHandEvaluator::evaluateShowdownReference(const vector<CardSet>& hands,
+        const CardSet& board,
+        vector<PokerHandEvaluation>& evals,
+        vector<EquityResult>& result,
+        double weight) const
+{
+    size_t nevals = evaluatePots(hands, board, evals);
+    awardReference(evals, nevals, result, weight);
     //display (hands, board, result);
 }
 
+void PokerHandEvaluator::evaluateShowdownExact(const vector<CardSet>& hands,
+        const CardSet& board,
+        vector<PokerHandEvaluation>& evals,
+        vector<EquityResult>& result,
+        ExactShares weight) const
+{
+    size_t nevals = evaluatePots(hands, board, evals);
+    awardUnits(evals, nevals, result, weight);
+}
+
+void PokerHandEvaluator::evaluateShowdown(const vector<CardSet>& hands,
+        const CardSet& board,
+        vector<PokerHandEvaluation>& evals,
+        const vector<SidePot>& pots,
+        vector<EquityResult>& result,
+        double weight) const
+{
+    evaluatePots(hands, board, evals);
+    awardPots(evals, pots, result, weight);
+}
+
+void PokerHandEvaluator::awardShowdown(const vector<PokerHandEvaluation>& evals,
+        vector<EquityResult>& result,
+        double weight) const
+{
+    awardShares(evals, potsInPlay(evals), result, weight);
+}
+
+void PokerHandEvaluator::awardShowdownExact(const vector<PokerHandEvaluation>& evals,
+        vector<EquityResult>& result,
+        ExactShares weight) const
+{
+    awardUnits(evals, potsInPlay(evals), result, weight);
+}
+
+void PokerHandEvaluator::awardPots(const vector<PokerHandEvaluation>& evals,
+        const vector<SidePot>& pots,
+        vector<EquityResult>& result,
+        double weight) const
+{
+    const size_t hsize = evals.size();
+    for (size_t p=0; p<pots.size(); p++)
+    {
+        const uint32_t players = pots[p].players;
+        if (players == 0)
+            continue;
+
+        // the pot is split high and low only if one of its players
+        // qualifies for the low
+        size_t nevals = 1;
+        for (size_t i=0; nevals == 1 && i<hsize; i++)
+            if ((players >> i & 1) && evals[i].eval(1) > PokerEvaluation(0))
+                nevals = 2;
+
+        for (size_t e=0; e<nevals; e++)
+        {
+            PokerEvaluation maxeval;
+            size_t winner = hsize;
+            size_t shares = 0;
+            for (size_t i=0; i<hsize; i++)
+            {
+                if (!(players >> i & 1))
+                    continue;
+                PokerEvaluation eval = evals[i].eval(e);
+                if (winner == hsize || eval > maxeval)
+                {
+                    shares = 1;
+                    maxeval = eval;
+                    winner = i;
+                }
+                else if (eval == maxeval)
+                {
+                    shares++;
+                }
+            }
+            if (winner == hsize)
+                continue;
+            const double chips = pots[p].amount*weight/static_cast<double>(nevals*shares);
+            if (shares == 1)
+            {
+                result[winner].winShares += chips;
+                continue;
+            }
+            for (size_t i=winner; i<hsize; i++)
+                if ((players >> i & 1) && evals[i].eval(e) == maxeval)
+                    result[i].tieShares += chips;
+        }
+    }
+}
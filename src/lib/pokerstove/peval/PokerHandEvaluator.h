@@ -16,6 +16,34 @@ const unsigned int BOARD_SIZE = 5;
 
 namespace pokerstove
 {
+/**
+ * Exact share counts are integers in units of 1/EXACT_SHARES_PER_POT of
+ * a pot.  The number of units is divisible by every way a pot can be
+ * split: between up to ten hands, in one or two pots.  The counts are
+ * 128 bit where the compiler supports it, so long enumerations with
+ * large weights do not overflow.
+ */
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 ExactShares;
+#else
+typedef uint64_t ExactShares;
+#endif
+const uint64_t EXACT_SHARES_PER_POT = 5040;
+const size_t EXACT_SHARES_MAX_HANDS = 10;
+
+/**
+ * evaluateShowdown finds the winners of up to this many hands with a
+ * packed compare, and falls back to the scan of evaluateShowdownReference
+ * above it.
+ */
+const size_t SHOWDOWN_KERNEL_HANDS = 10;
+
+/**
+ * Below this many hands a plain scan of the evaluations is cheaper than
+ * packing them for the compare.
+ */
+const size_t SHOWDOWN_KERNEL_MIN_HANDS = 5;
+
 /**
  * What is actually stored in the equity result is up to the evalutor
  * being used.  Usually it is either wins/ties, or m1/m2
@@ -26,21 +54,37 @@ struct EquityResult
     double tieShares;
     double equity;
     double equity2;  // second moment of equity
+    ExactShares winUnits;   // exact counts, see evaluateShowdownExact
+    ExactShares tieUnits;
 
     explicit EquityResult()
         : winShares(0.0)
         , tieShares(0.0)
         , equity(0.0)
         , equity2(0.0)
+        , winUnits(0)
+        , tieUnits(0)
     {}
 
     EquityResult& operator+=(const EquityResult& other)
     {
         winShares += other.winShares;
         tieShares += other.tieShares;
+        winUnits += other.winUnits;
+        tieUnits += other.tieUnits;
         return *this;
     }
 
+    /**
+     * Set the shares from the exact counts.  This is the only rounding
+     * in an exact calculation.
+     */
+    void setExactShares()
+    {
+        winShares = static_cast<double>(winUnits)/EXACT_SHARES_PER_POT;
+        tieShares = static_cast<double>(tieUnits)/EXACT_SHARES_PER_POT;
+    }
+
     std::string str() const
     {
         std::string ret =
@@ -52,6 +96,16 @@ struct EquityResult
     }
 };
 
+/**
+ * One pot of a showdown with side pots: the players who can win it, bit
+ * i for the ith hand, and its size in chips.
+ */
+struct SidePot
+{
+    uint32_t players;
+    double   amount;
+};
+
 /**
  * A base class for all simple hand evaluation classes.  All we are
  * trying to do here is to abstract the hand evaluation.  No
@@ -126,11 +180,50 @@ public:
         return evaluateHand(hand, board).eval(0);
     }
 
+    /**
+     * For split pot games, false when no hand can make a low on this
+     * board.  evaluateShowdown then uses evaluateHighHand, and skips the
+     * low work for every player.
+     */
+    virtual bool lowPossible(const CardSet& board) const
+    {
+        return true;
+    }
+
+    /**
+     * evaluateHand without the low half, for boards where lowPossible is
+     * false
+     */
+    virtual PokerHandEvaluation evaluateHighHand(const CardSet& hand,
+                                                 const CardSet& board=CardSet(0)) const
+    {
+        return evaluateHand(hand, board);
+    }
+
     virtual bool usesSuits() const
     {
         return _useSuits;
     }
 
+    /**
+     * The number of cards of one suit a hand and board need before the
+     * suits can change an evaluation, five for the flush games.  Below
+     * that, the evaluation depends only on the ranks.  Zero when the suits
+     * may matter however the cards fall.
+     */
+    virtual size_t flushSize() const
+    {
+        return 0;
+    }
+
+    /**
+     * the game string the evaluator was allocated with
+     */
+    std::string str() const
+    {
+        return _subclassID;
+    }
+
     void useSuits(bool use)
     {
         _useSuits = use;
@@ -165,6 +258,12 @@ public:
      * size as the result vector.  The hands vector is allowe to be larger
      * than that.  The board may or may not be used depending on how
      * evaluateHand is implemented.
+     *
+     * For SHOWDOWN_KERNEL_MIN_HANDS to SHOWDOWN_KERNEL_HANDS hands the
+     * evaluation codes are packed, and the winners of each pot are found
+     * as a bit mask in one pass of SIMD compares.  Fewer hands are
+     * scanned.  The results are identical to those of
+     * evaluateShowdownReference.
      */
     void evaluateShowdown(const std::vector<CardSet>& hands,
                           const pokerstove::CardSet& board,
@@ -172,10 +271,73 @@ public:
                           std::vector<EquityResult>& result,
                           double weight=1.0) const;
 
+    /**
+     * The straightforward version of evaluateShowdown, which scans the
+     * evaluations for the best hand and then again for ties.  Any number
+     * of hands.
+     */
+    void evaluateShowdownReference(const std::vector<CardSet>& hands,
+                                   const pokerstove::CardSet& board,
+                                   std::vector<PokerHandEvaluation>& evals,
+                                   std::vector<EquityResult>& result,
+                                   double weight=1.0) const;
+
+    /**
+     * evaluateShowdown with exact integer accounting.  The shares are
+     * accumulated in the winUnits and tieUnits of the results, in units
+     * of 1/EXACT_SHARES_PER_POT of a pot, multiplied by weight.  The sums
+     * do not depend on the order of accumulation.  At most
+     * EXACT_SHARES_MAX_HANDS hands may be evaluated.
+     */
+    void evaluateShowdownExact(const std::vector<CardSet>& hands,
+                               const pokerstove::CardSet& board,
+                               std::vector<PokerHandEvaluation>& evals,
+                               std::vector<EquityResult>& result,
+                               ExactShares weight=1) const;
+
+    /**
+     * Award the pots of a showdown whose hands are already evaluated,
+     * as evaluateShowdown and evaluateShowdownExact do once they have
+     * evaluated the hands.  This is for callers which evaluate the hands
+     * themselves, see OmahaPreparedEvaluator.
+     */
+    void awardShowdown(const std::vector<PokerHandEvaluation>& evals,
+                       std::vector<EquityResult>& result,
+                       double weight=1.0) const;
+    void awardShowdownExact(const std::vector<PokerHandEvaluation>& evals,
+                            std::vector<EquityResult>& result,
+                            ExactShares weight=1) const;
+
+    /**
+     * evaluateShowdown with side pots.  The hands are evaluated once, and
+     * each pot goes to the best of the players it is open to, split as
+     * the game splits a pot, high and low, and between ties.  The chips
+     * times weight are added to the shares of the results, the chips won
+     * alone to winShares and those split to tieShares.
+     */
+    void evaluateShowdown(const std::vector<CardSet>& hands,
+                          const pokerstove::CardSet& board,
+                          std::vector<PokerHandEvaluation>& evals,
+                          const std::vector<SidePot>& pots,
+                          std::vector<EquityResult>& result,
+                          double weight=1.0) const;
+    void awardPots(const std::vector<PokerHandEvaluation>& evals,
+                   const std::vector<SidePot>& pots,
+                   std::vector<EquityResult>& result,
+                   double weight=1.0) const;
+
 
 protected:
     PokerHandEvaluator();
 
+    /**
+     * fill in evals for the showdown, and return the number of pots
+     * (1 or 2) which anyone qualifies for
+     */
+    size_t evaluatePots(const std::vector<CardSet>& hands,
+                        const pokerstove::CardSet& board,
+                        std::vector<PokerHandEvaluation>& evals) const;
+
 private:
     // non-copyable
     PokerHandEvaluator(const PokerHandEvaluator&);
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "Card.h"
 #include "PokerHandEvaluator.h"
+#include "UniversalHandEvaluator.h"
 
 TEST(PokerHandEvaluator, OmahaHigh)
 {
@@ -9,3 +14,165 @@ TEST(PokerHandEvaluator, OmahaHigh)
     EXPECT_EQ(true, evaluator->usesSuits());
     EXPECT_EQ(5, evaluator->boardSize());
 }
+
+TEST(PokerHandEvaluator, ShowdownExact)
+{
+    using namespace pokerstove;
+
+    boost::shared_ptr<PokerHandEvaluator> evaluator = PokerHandEvaluator::alloc ("h");
+    std::vector<CardSet> hands = {CardSet("AcKd"), CardSet("AhKs"), CardSet("2c2d")};
+    CardSet board("QcJdTs3h4h");
+    std::vector<PokerHandEvaluation> evals(hands.size());
+    std::vector<EquityResult> exact(hands.size(), EquityResult());
+    std::vector<EquityResult> real(hands.size(), EquityResult());
+
+    evaluator->evaluateShowdownExact(hands, board, evals, exact, 3);
+    evaluator->evaluateShowdown(hands, board, evals, real, 3.0);
+    EXPECT_EQ(3*EXACT_SHARES_PER_POT/2, static_cast<uint64_t>(exact[0].tieUnits));
+    EXPECT_EQ(3*EXACT_SHARES_PER_POT/2, static_cast<uint64_t>(exact[1].tieUnits));
+    EXPECT_EQ(0, static_cast<uint64_t>(exact[2].winUnits + exact[2].tieUnits));
+    for (size_t i=0; i<hands.size(); i++)
+    {
+        exact[i].setExactShares();
+        EXPECT_EQ(real[i].winShares, exact[i].winShares);
+        EXPECT_EQ(real[i].tieShares, exact[i].tieShares);
+    }
+}
+
+TEST(PokerHandEvaluator, SidePots)
+{
+    using namespace pokerstove;
+
+    boost::shared_ptr<PokerHandEvaluator> evaluator = PokerHandEvaluator::alloc ("h");
+    std::vector<CardSet> hands = {CardSet("AcKd"), CardSet("AhKs"), CardSet("2c2d")};
+    CardSet board("QcJdTs3h4h");
+    std::vector<PokerHandEvaluation> evals(hands.size());
+    std::vector<EquityResult> chips(hands.size(), EquityResult());
+
+    // the straights split the main pot, the second player takes the
+    // side pot, and the pot only the third player is in goes back
+    std::vector<SidePot> pots = {{7, 30.0}, {6, 20.0}, {4, 10.0}};
+    evaluator->evaluateShowdown(hands, board, evals, pots, chips, 2.0);
+    EXPECT_EQ(30.0, chips[0].tieShares);
+    EXPECT_EQ(30.0, chips[1].tieShares);
+    EXPECT_EQ(40.0, chips[1].winShares);
+    EXPECT_EQ(20.0, chips[2].winShares);
+    EXPECT_EQ(0.0, chips[0].winShares + chips[2].tieShares);
+
+    // one pot everyone is in is the plain showdown, high low as well
+    evaluator = PokerHandEvaluator::alloc ("o");
+    hands = {CardSet("Ah2hKhKs"), CardSet("As3cJcJd"), CardSet("2s3sQdQc")};
+    board = CardSet("7h8d6h4c9s");
+    std::vector<EquityResult> shares(hands.size(), EquityResult());
+    chips.assign(hands.size(), EquityResult());
+    evaluator->evaluateShowdown(hands, board, evals, shares, 1.0);
+    evaluator->evaluateShowdown(hands, board, evals, std::vector<SidePot>(1, SidePot{7, 1.0}), chips);
+    for (size_t i=0; i<hands.size(); i++)
+    {
+        EXPECT_DOUBLE_EQ(shares[i].winShares, chips[i].winShares);
+        EXPECT_DOUBLE_EQ(shares[i].tieShares, chips[i].tieShares);
+    }
+}
+
+namespace {
+
+/**
+ * A board of boardsize cards from the live cards, as many of them in
+ * pairs as fit, so the hands play the board and tie often.
+ */
+pokerstove::CardSet pairedBoard(const std::vector<int>& live, size_t boardsize)
+{
+    std::vector<std::vector<int> > byRank(13);
+    for (size_t i=0; i<live.size(); i++)
+        byRank[live[i] % 13].push_back(live[i]);
+    pokerstove::CardSet board;
+    for (size_t r=0; r<byRank.size() && board.size()+2<=boardsize; r++)
+        if (byRank[r].size() >= 2)
+        {
+            board.insert(pokerstove::Card(byRank[r][0]));
+            board.insert(pokerstove::Card(byRank[r][1]));
+            byRank[r].clear();
+        }
+    for (size_t r=0; r<byRank.size() && board.size()<boardsize; r++)
+        for (size_t i=0; i<byRank[r].size() && board.size()<boardsize; i++)
+            board.insert(pokerstove::Card(byRank[r][i]));
+    return board;
+}
+
+}
+
+TEST(PokerHandEvaluator, ShowdownMatchesReference)
+{
+    using namespace pokerstove;
+
+    std::mt19937 rng(2012);
+    for (const char* game : {"h", "O", "o", "s", "e", "r", "l", "q"})
+    {
+        boost::shared_ptr<PokerHandEvaluator> evaluator = PokerHandEvaluator::alloc (game);
+        size_t handsize = evaluator->handSize();
+        size_t boardsize = evaluator->boardSize();
+        size_t maxhands = std::min<size_t>(SHOWDOWN_KERNEL_HANDS, (52-boardsize)/handsize);
+        std::vector<int> deck(52);
+        for (int c=0; c<52; c++)
+            deck[c] = c;
+
+        for (size_t nhands=2; nhands<=maxhands; nhands++)
+        {
+            std::vector<PokerHandEvaluation> evals(nhands);
+            std::vector<EquityResult> kernel(nhands, EquityResult());
+            std::vector<EquityResult> reference(nhands, EquityResult());
+            for (int trial=0; trial<200; trial++)
+            {
+                // deal from a shuffled deck, some trials with a paired
+                // board from the cards left, so there are plenty of ties
+                std::shuffle(deck.begin(), deck.end(), rng);
+                std::vector<CardSet> hands(nhands);
+                size_t next = 0;
+                for (size_t i=0; i<nhands; i++)
+                    for (size_t j=0; j<handsize; j++)
+                        hands[i].insert(Card(deck[next++]));
+                CardSet board;
+                for (size_t j=0; j<boardsize; j++)
+                    board.insert(Card(deck[next++]));
+                if (trial % 4 == 0 && boardsize > 0)
+                    board = pairedBoard(std::vector<int>(deck.begin()+next-boardsize, deck.end()),
+                                        boardsize);
+
+                evaluator->evaluateShowdown(hands, board, evals, kernel, trial+1.0);
+                evaluator->evaluateShowdownReference(hands, board, evals, reference, trial+1.0);
+            }
+            for (size_t i=0; i<nhands; i++)
+            {
+                EXPECT_EQ(reference[i].winShares, kernel[i].winShares) << game << " " << nhands;
+                EXPECT_EQ(reference[i].tieShares, kernel[i].tieShares) << game << " " << nhands;
+            }
+        }
+    }
+}
+
+TEST(PokerHandEvaluator, StudHighLow)
+{
+    using namespace pokerstove;
+
+    // the rule based evaluator 'q' used to be
+    UniversalHandEvaluator universal(1,7,0,0,0, &CardSet::evaluateHigh, &CardSet::evaluateLowA5);
+    boost::shared_ptr<PokerHandEvaluator> evaluator = PokerHandEvaluator::alloc ("q");
+    EXPECT_EQ(2, evaluator->evaluationSize());
+    EXPECT_EQ(7, evaluator->handSize());
+
+    std::mt19937 rng(47);
+    std::vector<int> deck(52);
+    for (int c=0; c<52; c++)
+        deck[c] = c;
+    for (int trial=0; trial<20000; trial++)
+    {
+        std::shuffle(deck.begin(), deck.end(), rng);
+        CardSet hand;
+        for (int j=0; j<1+trial%7; j++)
+            hand.insert(Card(deck[j]));
+        PokerHandEvaluation expected = universal.evaluateHand(hand, CardSet());
+        PokerHandEvaluation actual = evaluator->evaluateHand(hand, CardSet());
+        EXPECT_EQ(expected.high(), actual.high()) << hand.str();
+        EXPECT_EQ(expected.low(), actual.low()) << hand.str();
+    }
+}
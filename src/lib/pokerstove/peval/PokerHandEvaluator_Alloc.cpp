@@ -7,6 +7,7 @@
 #include "StudHandEvaluator.h"
 #include "RazzHandEvaluator.h"
 #include "StudEightHandEvaluator.h"
+#include "StudHighLowHandEvaluator.h"
 #include "OmahaHighHandEvaluator.h"
 #include "OmahaEightHandEvaluator.h"
 #include "DeuceToSevenHandEvaluator.h"
@@ -73,8 +74,8 @@ boost::shared_ptr<PokerHandEvaluator> PokerHandEvaluator::alloc(const string& st
             break;
 
         case 'q':       //     stud high/low no qualifier
-            ret.reset(new UniversalHandEvaluator(1,7,0,0,0,
-                                                 &CardSet::evaluateHigh, &CardSet::evaluateLowA5));
+            //ret.reset (new UniversalHandEvaluator (1,7,0,0,0,&CardSet::evaluateHigh, &CardSet::evaluateLowA5));
+            ret.reset(new StudHighLowHandEvaluator);
             break;
 
         case 'd':       //     draw high
@@ -24,6 +24,7 @@ public:
     virtual size_t handSize() const { return 7; }
     virtual size_t boardSize() const { return 0; }
     virtual size_t evaluationSize() const { return 2; }
+    virtual size_t flushSize() const { return 5; }
 };
 
 }
@@ -0,0 +1,33 @@
+/**
+ * Copyright (c) 2012 Andrew Prock. All rights reserved.
+ */
+#ifndef PEVAL_STUDHIGHLOWHANDEVALUATOR_H_
+#define PEVAL_STUDHIGHLOWHANDEVALUATOR_H_
+
+#include "PokerHandEvaluator.h"
+
+namespace pokerstove
+{
+/**
+ * Stud high/low with no qualifier, the high and the ace to five low of
+ * the hand.  The low is the razz evaluation, and the high that of stud,
+ * so one evaluation serves all three games, see
+ * ShowdownEnumerator::calculateStudEquity.
+ */
+class StudHighLowHandEvaluator : public PokerHandEvaluator
+{
+public:
+
+    virtual PokerHandEvaluation evaluateHand(const CardSet& hand, const CardSet&) const
+    {
+        return PokerHandEvaluation(hand.evaluateHigh(), hand.evaluateLowA5());
+    }
+
+    virtual size_t handSize() const { return 7; }
+    virtual size_t boardSize() const { return 0; }
+    virtual size_t evaluationSize() const { return 2; }
+    virtual size_t flushSize() const { return 5; }
+};
+
+}
+#endif  // PEVAL_STUDHIGHLOWHANDEVALUATOR_H_
@@ -12,6 +12,21 @@
 
 namespace pokerstove
 {
+  /**
+   * N choose K as an exact integer, zero when K > N
+   */
+  inline uint64_t choose (size_t n, size_t k)
+  {
+    if (k > n)
+      return 0;
+    if (k > n-k)
+      k = n-k;
+    uint64_t ret = 1;
+    for (size_t i=1; i<=k; i++)
+      ret = ret * (n-k+i) / i;
+    return ret;
+  }
+
   /**
    * Generates the set of all N choose K combinations of K
    * indices less than N.
@@ -108,6 +123,37 @@ namespace pokerstove
       return next();
     }
 
+    /**
+     * the number of combinations, N choose K
+     */
+    uint64_t count() const
+    {
+      return choose (n_, k_);
+    }
+
+    /**
+     * Jump to the combination with the given rank in the order generated
+     * by next().  The combinations are in lexicographic order, so the
+     * number of them which start with index c at position i is
+     * (N-c-1) choose (K-i-1).
+     */
+    void seek(uint64_t rank)
+    {
+      didnull_ = true;
+      size_t c = 0;
+      for (size_t i=0; i<k_; ++i, ++c)
+        {
+          for (uint64_t span = choose (n_-c-1, k_-i-1);
+               rank >= span;
+               span = choose (n_-c-1, k_-i-1))
+            {
+              rank -= span;
+              c++;
+            }
+          comb_[i] = c;
+        }
+    }
+
     size_t operator[](size_t i) const
     {
       return comb_[i];
@@ -1,4 +1,8 @@
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <boost/program_options.hpp>
 #include <pokerstove/penum/ShowdownEnumerator.h>
@@ -14,7 +18,12 @@ int main(int argc, char** argv) {
       ("game,g", po::value<string>()->default_value("h"), "game to use for evaluation")
       ("board,b", po::value<string>(), "community cards for he/o/o8")
       ("hand,h", po::value<vector<string>>(), "a hand for evaluation")
-      ("samples,s", po::value<int>(), "num of monte carlo samples")
+      ("samples,s", po::value<int>(), "num of monte carlo samples against random hands")
+      ("opponents,n", po::value<size_t>(), "random hands to play against, one for a single hand")
+      ("checkpoint,c", po::value<string>(), "save progress to, and resume from, this file")
+      ("shard", po::value<string>(), "compute only shard i/N of the runouts, 0 <= i < N")
+      ("exact,x", "count shares exactly, hand weights must be whole numbers")
+      ("output,o", po::value<string>(), "file for the partial results of a shard, see ps-merge")
       ("quiet,q", "produces no output");
 
   // make hand a positional argument
@@ -52,16 +61,81 @@ int main(int argc, char** argv) {
     handDists.back().parse(hand);
   }
 
-  // fill with random if necessary
-  if (handDists.size() == 1) {
-    handDists.emplace_back();
-    handDists.back().fill_random(evaluator->handSize(), vm["samples"].as<int>());
+  // random opponents are enumerated along with the board, or with
+  // samples, dealt from the same shuffled deck as the board
+  size_t opponents = vm.count("opponents") ? vm["opponents"].as<size_t>()
+                                           : (handDists.size() == 1 ? 1 : 0);
+  int samples = vm.count("samples") ? vm["samples"].as<int>() : 0;
+  if (samples < 0) {
+    cerr << "--samples must not be negative\n";
+    return 1;
   }
+  if (opponents == 0)
+    samples = 0;
+  if (samples == 0)
+    handDists.resize(handDists.size() + opponents);
 
-  // calcuate the results and print them
+  // calcuate the results and print them, picking up where a previous run
+  // left off if there is a checkpoint
   ShowdownEnumerator showdown;
-  vector<EquityResult> results =
-      showdown.calculateEquity(handDists, CardSet(board), evaluator);
+  showdown.useExactShares(vm.count("exact") > 0);
+  bool resume = false;
+  string checkpoint;
+  if (vm.count("checkpoint")) {
+    checkpoint = vm["checkpoint"].as<string>();
+    showdown.setCheckpoint(checkpoint);
+    resume = ifstream(checkpoint.c_str()).good();
+  }
+  vector<EquityResult> results;
+  try {
+    if (vm.count("shard")) {
+      if (samples > 0) {
+        cerr << "--shard enumerates, it does not take --samples\n";
+        return 1;
+      }
+      // a shard writes its partial results for ps-merge to combine
+      size_t index = 0;
+      size_t count = 0;
+      char slash = 0;
+      istringstream spec(vm["shard"].as<string>());
+      if (!(spec >> index >> slash >> count) || slash != '/' || !spec.eof()) {
+        cerr << "--shard must be of the form i/N\n";
+        return 1;
+      }
+      showdown.setShard(index, count);
+      string output = vm.count("output")
+          ? vm["output"].as<string>()
+          : "shard-" + to_string(index) + "-of-" + to_string(count) + ".pse";
+      PartialEquity partial =
+          showdown.calculatePartialEquity(handDists, CardSet(board), evaluator, resume);
+      // ps-merge prints the hands as they were given, empty for a random hand
+      for (size_t i = 0; i < partial.hands.size(); ++i) {
+        partial.hands[i] = (i < hands.size()) ? hands[i] : "";
+      }
+      partial.write(output);
+      // the run is done, so the checkpoint path is free for the next query
+      if (!checkpoint.empty())
+        remove(checkpoint.c_str());
+      if (!quiet) {
+        cout << "shard " << index << "/" << count << ": runouts " << partial.begin
+             << " to " << partial.end << " of " << partial.total
+             << ", written to " << output << endl;
+      }
+      return 0;
+    }
+    if (samples > 0)
+      results = showdown.calculateRandomEquity(handDists, opponents, CardSet(board),
+                                               evaluator, samples);
+    else
+      results = resume
+          ? showdown.resumeEquity(handDists, CardSet(board), evaluator)
+          : showdown.calculateEquity(handDists, CardSet(board), evaluator);
+    if (!checkpoint.empty())
+      remove(checkpoint.c_str());
+  } catch (std::exception& e) {
+    cerr << "-- caught exception--\n" << e.what() << "\n";
+    return 1;
+  }
 
   double total = 0.0;
   for (const EquityResult& result : results) {
@@ -0,0 +1,70 @@
+#include <iostream>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <pokerstove/penum/PartialEquity.h>
+
+using namespace pokerstove;
+namespace po = boost::program_options;
+using namespace std;
+
+int main(int argc, char** argv) {
+  po::options_description desc("ps-merge, combines the shards of a ps-eval --shard run\n");
+
+  desc.add_options()("help,?", "produce help message")
+      ("shard,s", po::value<vector<string>>(), "a partial result file written by ps-eval")
+      ("output,o", po::value<string>(), "also write the merged results to this file")
+      ("quiet,q", "produces no output");
+
+  // make shard a positional argument
+  po::positional_options_description p;
+  p.add("shard", -1);
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv)
+                .style(po::command_line_style::unix_style)
+                .options(desc)
+                .positional(p)
+                .run(),
+            vm);
+  po::notify(vm);
+
+  // check for help
+  if (vm.count("help") || vm.count("shard") == 0) {
+    cout << desc << endl;
+    return 1;
+  }
+
+  vector<string> files = vm["shard"].as<vector<string>>();
+  bool quiet = vm.count("quiet") > 0;
+
+  // read the shards and check they add up to one query
+  PartialEquity merged;
+  try {
+    vector<PartialEquity> shards(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+      shards[i].read(files[i]);
+    }
+    merged = PartialEquity::merge(shards);
+    if (vm.count("output")) {
+      merged.write(vm["output"].as<string>());
+    }
+  } catch (std::exception& e) {
+    cerr << "-- caught exception--\n" << e.what() << "\n";
+    return 1;
+  }
+
+  double total = 0.0;
+  for (const EquityResult& result : merged.results) {
+    total += result.winShares + result.tieShares;
+  }
+
+  if (!quiet) {
+    for (size_t i = 0; i < merged.results.size(); ++i) {
+      double equity = (merged.results[i].winShares + merged.results[i].tieShares) / total;
+      string handDesc =
+          merged.hands[i].empty() ? "A random hand" : "The hand " + merged.hands[i];
+      cout << handDesc << " has " << equity * 100. << " % equity ("
+           << merged.results[i].str() << ")" << endl;
+    }
+  }
+}